@@ -27,23 +27,46 @@ void Agent::connect(ipv4_address address, std::string agent_name, std::function<
 void Agent::addToAddressBook(ipv4_view address, std::string_view agent_name)
 {
     // std::cout << "Adding to address book " << address << " " << agent_name << "\n";
+    std::unique_lock lock{known_agents_mutex_};
     known_agents.left.insert({std::string{agent_name}, std::string{address}});
 }
 
 void Agent::removeFromAddressBook(std::string_view agent_name)
 {
+    std::unique_lock lock{known_agents_mutex_};
     known_agents.left.erase(std::string{agent_name});
 }
 
+Agent::ipv4_address Agent::addressOf(std::string_view agent_name)
+{
+    std::shared_lock lock{known_agents_mutex_};
+    auto agent = known_agents.left.find(std::string{agent_name});
+    if (agent == known_agents.left.end())
+    {
+        std::string msg = std::string{"Unknown agent name: "} + std::string{agent_name};
+        throw std::runtime_error(msg);
+    }
+    return agent->second;
+}
+
+std::optional<std::string> Agent::nameAt(ipv4_view address)
+{
+    std::shared_lock lock{known_agents_mutex_};
+    auto agent = known_agents.right.find(std::string{address});
+    if (agent == known_agents.right.end()) return std::nullopt;
+    return agent->second;
+}
+
 std::optional<MessagePtr> Agent::handleMessage(ipv4_view sender, MessagePtr message)
 {
     // std::cout << "In agent handle message" << "\n";
 
     // Check if sender is in known agents address book
-    if (known_agents.right.find(std::string(sender)) != known_agents.right.end())
+    std::optional<std::string> agent_name = nameAt(sender);
+    if (agent_name.has_value())
     {
         // Known sender from address book
-        return handleMessageFrom(known_agents.right.at(std::string(sender)), message);
+        return handleMessageFrom(agent_name.value(), message);
     }
     else
     {
@@ -56,44 +79,19 @@ std::optional<MessagePtr> Agent::handleMessage(ipv4_view sender, MessagePtr mess
 
 void Agent::handleBroadcast(ipv4_view sender, MessagePtr message)
 {
-    if (known_agents.right.find(std::string(sender)) != known_agents.right.end())
-    {
-        // Known sender from address book
-        handleBroadcastFrom(known_agents.right.at(std::string(sender)), message);
-    }
-    else
-    {
-        // Unknown sender
-        handleBroadcastFrom("unknown", message);
-    }
+    // Known sender from address book, or unknown sender
+    handleBroadcastFrom(nameAt(sender).value_or("unknown"), message);
 }
 
 void Agent::sendMessageTo(std::string_view agent_name, MessagePtr message, bool async)
 {
     // std::cout << "Sending message to " << agent_name << "\n";
-    if (known_agents.left.find(std::string{agent_name}) != known_agents.left.end())
-    {
-        // std::cout << "Agent found in address book\n";
-        network()->sendMessage(known_agents.left.at(std::string{agent_name}), message, async);
-    }
-    else
-    {
-        std::string msg = std::string{"Unknown agent name: "} + std::string{agent_name};
-        throw std::runtime_error(msg);
-    }
+    network()->sendMessage(addressOf(agent_name), message, async);
 }
 
 void Agent::sendBroadcastTo(std::string_view agent_name, MessagePtr message)
 {
-    if (known_agents.left.find(std::string{agent_name}) != known_agents.left.end())
-    {
-        network()->sendBroadcast(known_agents.left.at(std::string{agent_name}), message);
-    }
-    else
-    {
-        std::string msg = std::string{"Unknown agent name: "} + std::string{agent_name};
-        throw std::runtime_error(msg);
-    }
+    network()->sendBroadcast(addressOf(agent_name), message);
 }
 
 void Agent::sendBroadcast(std::string_view address, MessagePtr message)
@@ -101,6 +99,24 @@ void Agent::sendBroadcast(std::string_view address, MessagePtr message)
     network()->sendBroadcast(address, message);
 }
 
+void Agent::sendMessagesTo(std::vector<std::pair<std::string, MessagePtr>> const& messages, bool async)
+{
+    for (auto const& [agent_name, message] : messages)
+    {
+        network()->postMessage(addressOf(agent_name), message, async);
+    }
+}
+
+void Agent::sendBroadcast(EndpointList endpoints, MessagePtr message)
+{
+    network()->sendBroadcast(std::move(endpoints), message);
+}
+
+void Agent::sendBroadcasts(std::vector<Broadcast>& broadcasts)
+{
+    network()->sendBroadcasts(broadcasts);
+}
+
 NetworkEntity* Agent::network()
 {
     return network_;
@@ -111,6 +127,26 @@ unsigned int Agent::myPort()
     return network()->port();
 }
 
+BroadcastStats const& Agent::broadcastStats()
+{
+    return network()->broadcastStats();
+}
+
+WriteStats const& Agent::writeStats()
+{
+    return network()->writeStats();
+}
+
+void Agent::setMulticastInterface()
+{
+    network()->setMulticastInterface();
+}
+
+void Agent::joinMulticastGroup(ipv4_view group)
+{
+    network()->joinMulticastGroup(group);
+}
+
 std::string Agent::myAddr()
 {
     return network()->addr();
@@ -3,12 +3,18 @@
 
 #include <iostream>
 #include <tuple>
+#include <optional>
+#include <shared_mutex>
 #include <boost/asio.hpp>
 #include <boost/bimap.hpp>
 
 #include "../config/agentconfig.hpp"
+#include "../utilities/logger.hpp"
 #include "../message/message.hpp"
 #include "../message/messagetype.hpp"
+#include "../networking/broadcaststats.hpp"
+#include "../networking/writestats.hpp"
+#include "../networking/broadcast.hpp"
 
 namespace asio = boost::asio;
 
@@ -43,7 +49,8 @@ public:
     /** Establishes a lasting connection with the agent at the given address. */
     void connect(ipv4_address address, std::string agent_name, std::function<void()> const& callback);
 
-    /** Sends a message to the known agent with the given name. */
+    /** Sends a message to the known agent with the given name. Unless async, it is written straight away rather
+     *  than left to the connection's writer, trading a system call on the caller for lower latency. */
     void sendMessageTo(std::string_view agent_name, MessagePtr message, bool async = false);
 
     /** Sends a broadcast to the agent with the given name. */
@@ -52,6 +59,15 @@ public:
     /** Sends a broadcast to the agent at the given address. */
     void sendBroadcast(std::string_view address, MessagePtr message);
 
+    /** Sends each message to the known agent with the given name as a single batch. */
+    void sendMessagesTo(std::vector<std::pair<std::string, MessagePtr>> const& messages, bool async = false);
+
+    /** Sends a broadcast to each of the given endpoints, serialising it only once. */
+    void sendBroadcast(EndpointList endpoints, MessagePtr message);
+
+    /** Sends each broadcast to its endpoints as a single batch, leaving the given vector empty with its capacity kept. */
+    void sendBroadcasts(std::vector<Broadcast>& broadcasts);
+
     /** Adds the given agent to the address book. */
     void addToAddressBook(ipv4_view address, std::string_view agent_name);
 
@@ -72,6 +88,18 @@ protected:
     /** Returns the public IPv4 address of the agent. */
     std::string myAddr();
 
+    /** Returns the timings of the batched broadcasts sent by the agent. */
+    BroadcastStats const& broadcastStats();
+
+    /** Returns the number of messages gathered into each TCP write sent by the agent. */
+    WriteStats const& writeStats();
+
+    /** Sends the agent's multicast broadcasts through the interface of its own address. */
+    void setMulticastInterface();
+
+    /** Joins the multicast group with the given IPv4 address to receive its broadcasts. */
+    void joinMulticastGroup(ipv4_view group);
+
     /** Derived classes must implement these: */
 
     /** Handles an incoming message and returns the message to send. */
@@ -90,7 +118,16 @@ private:
 
     NetworkEntity* network();
 
+    /** Returns the address of the known agent with the given name, failing if there is none. */
+    ipv4_address addressOf(std::string_view agent_name);
+
+    /** Returns the name of the known agent at the given address, if there is one. */
+    std::optional<std::string> nameAt(ipv4_view address);
+
     NetworkEntity* network_;
+
+    /** Guards the address book, which IO threads and the agent's own threads use at once. */
+    std::shared_mutex known_agents_mutex_;
 };
 
 #endif
\ No newline at end of file
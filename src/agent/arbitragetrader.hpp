@@ -48,7 +48,7 @@ public:
 
     void onTradingStart() override
     {
-        std::cout << "Trading window started.\n";
+        LOG_INFO << "Trading window started.";
         is_trading_ = true;
         activelyTrade();
     }
@@ -56,7 +56,7 @@ public:
     void onTradingEnd() override
     {
         std::unique_lock<std::mutex> lock(mutex_);
-        std::cout << "Trading window ended.\n";
+        LOG_INFO << "Trading window ended.";
         is_trading_ = false;
         lock.unlock();
     }
@@ -118,7 +118,7 @@ private:
             }
             lock.unlock();
 
-            std::cout << "Finished actively trading.\n";
+            LOG_INFO << "Finished actively trading.";
         });
     }
 
@@ -136,17 +136,17 @@ private:
     void updateMarketData(std::string_view exchange, MarketDataPtr data)
     {
         // Update best known ask (ovewrite best ask if was from this exchange)
-        if (best_ask_exchange_ == std::string{exchange} || data->best_ask < best_ask_price_)
+        if (best_ask_exchange_ == std::string{exchange} || data->best_ask.toDouble() < best_ask_price_)
         {
-            best_ask_price_ = data->best_ask;
+            best_ask_price_ = data->best_ask.toDouble();
             best_ask_size_ = data->best_ask_size;
             best_ask_exchange_ = std::string{exchange};
         }
 
         // Update best known bid (ovewrite best bid if was from this exchange)
-        if (best_bid_exchange_ == std::string{exchange} || data->best_bid > best_bid_price_)
+        if (best_bid_exchange_ == std::string{exchange} || data->best_bid.toDouble() > best_bid_price_)
         {
-            best_bid_price_ = data->best_bid;
+            best_bid_price_ = data->best_bid.toDouble();
             best_bid_size_ = data->best_bid_size;
             best_bid_exchange_ = std::string{exchange};
         }
@@ -182,13 +182,13 @@ private:
         double bid_price = std::floor(midpoint);
         double ask_price = std::ceil(midpoint);
 
-        std::cout << "[Opportunity] " 
+        LOG_DEBUG << "[Opportunity] " 
         << "BEST BID: " << best_bid_exchange_ << " @ " << best_bid_price_ << " "
-        << "BEST ASK: " << best_ask_exchange_ << " @ " << best_ask_price_ << std::endl;
+        << "BEST ASK: " << best_ask_exchange_ << " @ " << best_ask_price_;
         
-        std::cout << "[Arbitrage] " 
+        LOG_DEBUG << "[Arbitrage] " 
         << "BID: " << best_ask_exchange_ << " @ " <<  bid_price 
-        << " ASK: " << best_bid_exchange_ << " @ " << ask_price << std::endl;
+        << " ASK: " << best_bid_exchange_ << " @ " << ask_price;
 
         // Note: Arbitrageur places bid order on the exchange with best ask and vice versa
         placeLimitOrder(best_ask_exchange_, Order::Side::BID, ticker_, size, bid_price, ask_price);
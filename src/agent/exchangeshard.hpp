@@ -0,0 +1,172 @@
+#ifndef EXCHANGE_SHARD_HPP
+#define EXCHANGE_SHARD_HPP
+
+#include <map>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <unordered_map>
+
+#include "../order/orderbook.hpp"
+#include "../order/orderfactory.hpp"
+#include "../trade/tradefactory.hpp"
+#include "../trade/marketdepth.hpp"
+#include "../utilities/ringqueue.hpp"
+#include "../utilities/csvwriter.hpp"
+#include "../utilities/memorypool.hpp"
+#include "../message/message.hpp"
+#include "../networking/broadcast.hpp"
+#include "../message/exec_report_message.hpp"
+#include "../message/cancel_reject_message.hpp"
+#include "../message/market_data_message.hpp"
+#include "../message/market_depth_message.hpp"
+#include "../message/market_by_order_message.hpp"
+
+/** Level 2 updates sent to the subscribers of a single depth. */
+struct DepthStream
+{
+    unsigned long long sequence = 0;
+
+    /** The levels within the depth as last published. */
+    std::vector<DepthUpdate> levels;
+};
+
+/** Market data publication state of a single ticker. Snapshots are only published when the
+ *  order book has changed and, if a minimum interval is set, no more often than that. */
+struct TickerFeed
+{
+    OrderBookPtr order_book;
+    std::chrono::steady_clock::duration min_publish_interval;
+    std::chrono::steady_clock::time_point last_published {};
+    unsigned long long published_version = 0;
+    bool pending = false;
+
+    /** The price levels as last published on the level 2 feed. */
+    MarketDepth depth;
+
+    /** The level 2 stream of each subscribed depth, 0 for the full book. */
+    std::map<int, DepthStream> depth_streams;
+
+    /** Whether the published levels are kept up to date, which they are only while someone subscribes to level 2. */
+    bool depth_tracked = false;
+
+    /** Buffers reused by every level 2 publication, so publishing does not allocate once they have grown. */
+    std::vector<DepthUpdate> book_updates;
+    std::vector<DepthUpdate> updates;
+    std::vector<DepthUpdate> levels;
+    std::vector<int> depths;
+};
+
+/** A group of tickers matched on a dedicated thread. Each shard owns its inbound queue,
+ *  message tape and object pools, so shards never contend with each other.
+ *  Order and trade ids are interleaved across shards to stay unique within the exchange. */
+struct ExchangeShard
+{
+    /** Number of objects added to a pool each time it runs out. */
+    static constexpr size_t POOL_SLAB_SIZE = 4096;
+
+    /** Maximum number of inbound messages matched per batch. */
+    static constexpr size_t BATCH_SIZE = 256;
+
+    /** How long the matching engine waits between checks on held back snapshots while idle. */
+    static constexpr std::chrono::microseconds PENDING_FEED_POLL_INTERVAL {100};
+
+    ExchangeShard(int index, int shard_count, bool huge_pages)
+    : index{index},
+      tickers{},
+      limit_order_pool{"limit orders", POOL_SLAB_SIZE, huge_pages},
+      market_order_pool{"market orders", POOL_SLAB_SIZE, huge_pages},
+      trade_pool{"trades", POOL_SLAB_SIZE, huge_pages},
+      execution_report_pool{"execution reports", POOL_SLAB_SIZE, huge_pages},
+      cancel_reject_pool{"cancel rejects", POOL_SLAB_SIZE, huge_pages},
+      market_data_pool{"market data", POOL_SLAB_SIZE, huge_pages},
+      market_data_message_pool{"market data messages", POOL_SLAB_SIZE, huge_pages},
+      market_depth_message_pool{"market depth messages", POOL_SLAB_SIZE, huge_pages},
+      market_by_order_message_pool{"market by order messages", POOL_SLAB_SIZE, huge_pages},
+      msg_queue{},
+      batch(BATCH_SIZE),
+      pending_reports{},
+      pending_broadcasts{},
+      pending_rows{},
+      feeds{},
+      order_factory{&limit_order_pool, &market_order_pool, index, shard_count},
+      trade_factory{&trade_pool, index, shard_count}
+    {
+    }
+
+    /** Prints the occupancy of the shard's object pools. */
+    void reportPoolOccupancy(std::ostream& os) const
+    {
+        limit_order_pool.pool().report(os);
+        market_order_pool.pool().report(os);
+        trade_pool.pool().report(os);
+        execution_report_pool.pool().report(os);
+        cancel_reject_pool.pool().report(os);
+        market_data_pool.pool().report(os);
+        market_data_message_pool.pool().report(os);
+        market_depth_message_pool.pool().report(os);
+        market_by_order_message_pool.pool().report(os);
+    }
+
+    /** Records the current time as the start of a new batch. */
+    void stampBatch()
+    {
+        std::chrono::system_clock::duration now = std::chrono::system_clock::now().time_since_epoch();
+        batch_timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+    }
+
+    /** The position of the shard within the exchange. */
+    int index;
+
+    /** Tickers matched by this shard. */
+    std::vector<std::string> tickers;
+
+    /** Pools recycling the objects created by the matching engine, declared first to outlive their users.
+     *  Messages carrying buffers are kept alive between uses so the buffers keep their capacity. */
+    ObjectPool<LimitOrder> limit_order_pool;
+    ObjectPool<MarketOrder> market_order_pool;
+    ObjectPool<Trade> trade_pool;
+    ObjectPool<ExecutionReportMessage> execution_report_pool;
+    ObjectPool<CancelRejectMessage> cancel_reject_pool;
+    ObjectPool<MarketData> market_data_pool;
+    ObjectPool<MarketDataMessage> market_data_message_pool;
+    RecyclingPool<MarketDepthMessage> market_depth_message_pool;
+    RecyclingPool<MarketByOrderMessage> market_by_order_message_pool;
+
+    /** Lock-free FIFO queue for incoming messages to be processed by the shard's matching engine. */
+    RingQueue<MessagePtr> msg_queue;
+
+    /** Inbound messages of the batch being matched. */
+    std::vector<MessagePtr> batch;
+
+    /** Execution reports to each trader and broadcasts to each group of endpoints produced by the current batch. */
+    std::vector<std::pair<std::string, MessagePtr>> pending_reports;
+    std::vector<Broadcast> pending_broadcasts;
+
+    /** Rows produced by the current batch for each CSV file. */
+    std::unordered_map<CSVWriterPtr, std::vector<CSVPrintablePtr>> pending_rows;
+
+    /** Market data publication state of each ticker matched by this shard. */
+    std::unordered_map<std::string, TickerFeed> feeds;
+
+    /** Number of feeds holding back a snapshot until their minimum interval elapses. */
+    size_t pending_feeds = 0;
+
+    /** Time the current batch started matching, stamped on the market data it publishes. */
+    unsigned long long batch_timestamp = 0;
+
+    /** Message tape for each message processed by the shard. */
+    CSVWriterPtr message_tape;
+
+    OrderFactory order_factory;
+    TradeFactory trade_factory;
+
+    std::thread* matching_engine_thread = nullptr;
+
+    /** Position of the subscriber list the next market data broadcast starts from. */
+    size_t broadcast_rotation = 0;
+};
+
+typedef std::shared_ptr<ExchangeShard> ExchangeShardPtr;
+
+#endif
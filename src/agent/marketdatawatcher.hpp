@@ -40,7 +40,12 @@ private:
     /** Checks the type of the incoming message and makes a callback. */
     std::optional<MessagePtr> handleMessageFrom(std::string_view sender, MessagePtr message) override
     {
-        std::cout << "Market Data Watcher received a message" << std::endl;
+        if (message->type == MessageType::MULTICAST_GROUP)
+        {
+            joinMulticastGroup(std::dynamic_pointer_cast<MulticastGroupMessage>(message)->group);
+            return std::nullopt;
+        }
+        LOG_INFO << "Market Data Watcher received a message";
         return std::nullopt;
     }
 
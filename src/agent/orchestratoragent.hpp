@@ -21,8 +21,8 @@ public:
     void configureSimulation(SimulationConfigPtr simulation)
     {
         configuration_thread_ = new std::thread([&](){
-            std::cout << "Simulation repetitions: " << simulation->repetitions() 
-            << " time: " << simulation->time() << " seconds." << std::endl;
+            LOG_INFO << "Simulation repetitions: " << simulation->repetitions() 
+            << " time: " << simulation->time() << " seconds.";
 
             for (int i = 0; i < simulation->repetitions(); i++)
             {
@@ -42,18 +42,18 @@ public:
                 }
 
                 // Wait for this trial to finish before starting the next one
-                std::cout << "Simulation " << i << " configured." << std::endl;
-                std::cout << "Waiting " << simulation->time() << " seconds for simulation trial to end..." << std::endl;
+                LOG_INFO << "Simulation " << i << " configured.";
+                LOG_INFO << "Waiting " << simulation->time() << " seconds for simulation trial to end...";
                 std::this_thread::sleep_for(std::chrono::seconds(simulation->time()));
             }
-            std::cout << "Finished all " << simulation->repetitions() << " simulation trials." << std::endl;
+            LOG_INFO << "Finished all " << simulation->repetitions() << " simulation trials.";
         });
     }
 
     /** Sends a config message to the simulation node at the given address. */
     void configureNode(AgentConfigPtr config)
     {
-        std::cout << "Initialising agent: " << to_string(config->type) << " with addr: " << config->addr << "\n";
+        LOG_INFO << "Initialising agent: " << to_string(config->type) << " with addr: " << config->addr;
         this->connect(std::string(config->addr), std::to_string(config->agent_id), [=, this](){
 
             ConfigMessagePtr msg = std::make_shared<ConfigMessage>();
@@ -69,14 +69,14 @@ private:
     /** Checks the type of the incoming message and makes a callback. */
     std::optional<MessagePtr> handleMessageFrom(std::string_view sender, MessagePtr message) override
     {
-        std::cout << "Orchestrator received a message" << "\n";
+        LOG_INFO << "Orchestrator received a message";
         return std::nullopt;
     }
 
     /** Checks the type of the incoming broadcast and makes a callback. */
     void handleBroadcastFrom(std::string_view sender, MessagePtr message) override 
     {
-        std::cout << "Orchestrator received a broadcast" << "\n";
+        LOG_INFO << "Orchestrator received a broadcast";
     }
 
     std::thread* configuration_thread_;
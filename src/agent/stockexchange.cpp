@@ -1,24 +1,37 @@
+#include <limits>
 #include <algorithm>
-#include <stack>
+#include <sstream>
 
 #include "stockexchange.hpp"
-#include "../utilities/syncqueue.hpp"
+#include "../networking/networkentity.hpp"
 
 void StockExchange::start()
 {
-    // Create a Matching Engine Thread
-    matching_engine_thread_ = new std::thread(&StockExchange::runMatchingEngine, this);
+    // Create a Matching Engine Thread for each shard
+    for (ExchangeShardPtr shard : shards_)
+    {
+        shard->matching_engine_thread = new std::thread(&StockExchange::runMatchingEngine, this, shard);
+    }
     
+    if (!multicast_groups_.empty())
+    {
+        setMulticastInterface();
+    }
+
     // Main thread continues to handle incoming and outgoing communication
     Agent::start();
 };
 
 void StockExchange::terminate()
 {
-    if (matching_engine_thread_ != nullptr)
+    for (ExchangeShardPtr shard : shards_)
     {
-        matching_engine_thread_->join();
-        delete(matching_engine_thread_);
+        if (shard->matching_engine_thread != nullptr)
+        {
+            shard->matching_engine_thread->join();
+            delete(shard->matching_engine_thread);
+            shard->matching_engine_thread = nullptr;
+        }
     }
 
     if (trading_window_thread_ != nullptr)
@@ -28,89 +41,152 @@ void StockExchange::terminate()
     }
 }
 
-void StockExchange::runMatchingEngine()
+void StockExchange::runMatchingEngine(ExchangeShardPtr shard)
 {
     // Wait until trading window opens
     std::unique_lock<std::mutex> trading_window_lock(trading_window_mutex_);
-    trading_window_cv_.wait(trading_window_lock, [this]{ return trading_window_open_;});
+    trading_window_cv_.wait(trading_window_lock, [this]{ return trading_window_open_.load();});
+    trading_window_lock.unlock();
 
-    // Atomically check if trading window is open, and if not break loop
-    while (trading_window_open_)
+    // Check the session state once per batch rather than once per message
+    while (trading_window_open_.load(std::memory_order_acquire))
     {
-        trading_window_lock.unlock();
-        // std::cout << "Matching engine unlocked" << "\n";
-        
-        // Wait until new message is present
-        MessagePtr msg = msg_queue_.pop();
-        if (msg != nullptr)
-        {
-            // Pattern match the message type
-            switch (msg->type) {
-                case MessageType::MARKET_ORDER:
-                {
-                    onMarketOrder(std::dynamic_pointer_cast<MarketOrderMessage>(msg));
-                    break;
-                }
-                case MessageType::LIMIT_ORDER:
-                {
-                    onLimitOrder(std::dynamic_pointer_cast<LimitOrderMessage>(msg));
-                    break;
-                }
-                case MessageType::CANCEL_ORDER:
-                {
-                    onCancelOrder(std::dynamic_pointer_cast<CancelOrderMessage>(msg));
-                    break;
-                }
-                default:
-                {
-                    std::cout << "Exchange received unknown message type" << "\n";
-                }
-            }
+        // Drain up to a full batch, waiting for new messages only if none are queued
+        size_t count = shard->msg_queue.try_pop_n(shard->batch.data(), shard->batch.size());
+        if (count == 0 && shard->pending_feeds > 0)
+        {
+            // Keep polling while snapshots are held back so they go out once their interval elapses
+            std::this_thread::sleep_for(ExchangeShard::PENDING_FEED_POLL_INTERVAL);
+            shard->stampBatch();
+            publishPendingMarketData(*shard);
+            flushBatch(*shard);
+            continue;
+        }
+        else if (count == 0)
+        {
+            MessagePtr msg = shard->msg_queue.pop();
+            if (msg == nullptr) continue;
 
-            msg->markProcessed();
-            addMessageToTape(msg);
+            shard->batch[0] = msg;
+            count = 1 + shard->msg_queue.try_pop_n(shard->batch.data() + 1, shard->batch.size() - 1);
         }
-        
-        // std::cout << "Matching engine attempting to lock" << "\n";
-        trading_window_lock.lock();
-        // std::cout << "Matching engine locked" << "\n";
+
+        // Match the messages in sequence, then hand their output downstream at once
+        shard->stampBatch();
+        for (size_t i = 0; i < count; ++i)
+        {
+            processMessage(*shard, shard->batch[i]);
+            shard->batch[i] = nullptr;
+        }
+        publishPendingMarketData(*shard);
+        flushBatch(*shard);
     }
 
-    std::cout << "Matching Engine stopping." << "\n";
+    // Write out the shard's remaining rows and close its CSV files
+    shard->message_tape->stop();
+    for (std::string const& ticker : shard->tickers)
+    {
+        getTradeTapeFor(ticker)->stop();
+        getMarketDataFeedFor(ticker)->stop();
+    }
 
-    trading_window_lock.unlock();
-    std::cout << "Stopped running matching engine" << "\n";
-    // trading_window_cv_.notify_all();
+    LOG_INFO << "Matching Engine stopping.";
+    LOG_INFO << "Stopped running matching engine";
+};
+
+void StockExchange::processMessage(ExchangeShard& shard, MessagePtr msg)
+{
+    // Pattern match the message type
+    switch (msg->type) {
+        case MessageType::MARKET_ORDER:
+        {
+            onMarketOrder(shard, std::dynamic_pointer_cast<MarketOrderMessage>(msg));
+            break;
+        }
+        case MessageType::LIMIT_ORDER:
+        {
+            onLimitOrder(shard, std::dynamic_pointer_cast<LimitOrderMessage>(msg));
+            break;
+        }
+        case MessageType::CANCEL_ORDER:
+        {
+            onCancelOrder(shard, std::dynamic_pointer_cast<CancelOrderMessage>(msg));
+            break;
+        }
+        case MessageType::SNAPSHOT_REQUEST:
+        {
+            onSnapshotRequest(shard, std::dynamic_pointer_cast<SnapshotRequestMessage>(msg));
+            break;
+        }
+        default:
+        {
+            LOG_WARN << "Exchange received unknown message type";
+        }
+    }
+
+    msg->markProcessed();
+    addMessageToTape(shard, msg);
+};
+
+void StockExchange::flushBatch(ExchangeShard& shard)
+{
+    // Reports go out before market data, as when they were sent one by one
+    if (!shard.pending_reports.empty())
+    {
+        sendMessagesTo(shard.pending_reports);
+        shard.pending_reports.clear();
+    }
+    if (!shard.pending_broadcasts.empty())
+    {
+        sendBroadcasts(shard.pending_broadcasts);
+    }
+
+    // Hand the batch's tape rows to the CSV writers
+    for (auto& [writer, rows] : shard.pending_rows)
+    {
+        if (!rows.empty())
+        {
+            writer->writeRows(rows);
+            rows.clear();
+        }
+    }
 };
 
-void StockExchange::onLimitOrder(LimitOrderMessagePtr msg)
+void StockExchange::onLimitOrder(ExchangeShard& shard, LimitOrderMessagePtr msg)
 {
-    LimitOrderPtr order = order_factory_.createLimitOrder(msg);
+    LimitOrderPtr order = shard.order_factory.createLimitOrder(msg);
 
-    if (crossesSpread(order))
+    // Reject orders priced outside the ticker's tick grid or price band
+    if (!getOrderBookFor(order->ticker)->isValidPrice(order->price))
+    {
+        cancelOrder(shard, order);
+    }
+    else if (crossesSpread(order))
     {
         if (order->time_in_force == Order::TimeInForce::FOK)
         {
-            matchOrderInFull(order);
+            matchOrderInFull(shard, order);
         }
         else
         {
-            matchOrder(order);
+            matchOrder(shard, order);
         }
     }
     else
     {
         getOrderBookFor(order->ticker)->addOrder(order);
-        ExecutionReportMessagePtr report = ExecutionReportMessage::createFromOrder(order);
+        ExecutionReportMessagePtr report = ExecutionReportMessage::createFromOrder(snapshotOrder(shard, order), &shard.execution_report_pool);
         report->sender_id = this->agent_id;
-        sendExecutionReport(std::to_string(order->sender_id), report);
-        publishMarketData(msg->ticker);
-    }    
+        sendExecutionReport(shard, std::to_string(order->sender_id), report);
+    }
+
+    // Publish the resulting market data once per inbound order
+    publishMarketData(shard, msg->ticker);
 };
 
-void StockExchange::onMarketOrder(MarketOrderMessagePtr msg)
+void StockExchange::onMarketOrder(ExchangeShard& shard, MarketOrderMessagePtr msg)
 {
-    MarketOrderPtr order = order_factory_.createMarketOrder(msg);
+    MarketOrderPtr order = shard.order_factory.createMarketOrder(msg);
 
     if (msg->side == Order::Side::BID)
     {
@@ -118,11 +194,9 @@ void StockExchange::onMarketOrder(MarketOrderMessagePtr msg)
 
         while (best_ask.has_value() && !order->isFilled())
         {
-            getOrderBookFor(msg->ticker)->popBestAsk();
-
-            TradePtr trade = trade_factory_.createFromLimitAndMarketOrders(best_ask.value(), order);
-            addTradeToTape(trade);
-            executeTrade(best_ask.value(), order, trade);
+            TradePtr trade = shard.trade_factory.createFromLimitAndMarketOrders(best_ask.value(), order);
+            addTradeToTape(shard, trade);
+            executeTrade(shard, best_ask.value(), order, trade);
 
             best_ask = getOrderBookFor(order->ticker)->bestAsk();
         }
@@ -133,11 +207,9 @@ void StockExchange::onMarketOrder(MarketOrderMessagePtr msg)
 
         while (best_bid.has_value() && !order->isFilled())
         {
-            getOrderBookFor(msg->ticker)->popBestBid();
-
-            TradePtr trade = trade_factory_.createFromLimitAndMarketOrders(best_bid.value(), order);
-            addTradeToTape(trade);
-            executeTrade(best_bid.value(), order, trade);
+            TradePtr trade = shard.trade_factory.createFromLimitAndMarketOrders(best_bid.value(), order);
+            addTradeToTape(shard, trade);
+            executeTrade(shard, best_bid.value(), order, trade);
 
             best_bid = getOrderBookFor(order->ticker)->bestBid();
         }
@@ -146,27 +218,32 @@ void StockExchange::onMarketOrder(MarketOrderMessagePtr msg)
     // If the market order is not fully executed, cancel the remaining quantity
     if (!order->isFilled())
     {
-        cancelOrder(order);
+        cancelOrder(shard, order);
     }
+
+    // Publish the resulting market data once per inbound order
+    publishMarketData(shard, msg->ticker);
 };
 
-void StockExchange::onCancelOrder(CancelOrderMessagePtr msg)
+void StockExchange::onCancelOrder(ExchangeShard& shard, CancelOrderMessagePtr msg)
 {
     std::optional<LimitOrderPtr> order = getOrderBookFor(msg->ticker)->removeOrder(msg->order_id, msg->side);
     
     if (order.has_value()) 
     {
-        cancelOrder(order.value());
+        cancelOrder(shard, order.value());
     }
     else
     {
         // Send a cancel reject message if order does not exist in the order book
-        CancelRejectMessagePtr reject = std::make_shared<CancelRejectMessage>();
+        CancelRejectMessagePtr reject = shard.cancel_reject_pool.create();
         reject->sender_id = this->agent_id;
         reject->order_id = msg->order_id;
 
-        sendMessageTo(std::to_string(msg->sender_id), std::dynamic_pointer_cast<Message>(reject), true);
+        shard.pending_reports.push_back({std::to_string(msg->sender_id), std::dynamic_pointer_cast<Message>(reject)});
     }
+
+    publishMarketData(shard, msg->ticker);
 };
 
 bool StockExchange::crossesSpread(LimitOrderPtr order)
@@ -190,18 +267,16 @@ bool StockExchange::crossesSpread(LimitOrderPtr order)
     return false;
 };
 
-void StockExchange::matchOrder(LimitOrderPtr order)
+void StockExchange::matchOrder(ExchangeShard& shard, LimitOrderPtr order)
 {
     if (order->side == Order::Side::BID) {
         std::optional<LimitOrderPtr> best_ask = getOrderBookFor(order->ticker)->bestAsk();
         
         while (best_ask.has_value() && !order->isFilled() && order->price >= best_ask.value()->price)
         {
-            getOrderBookFor(order->ticker)->popBestAsk();
-
-            TradePtr trade = trade_factory_.createFromLimitOrders(best_ask.value(), order);
-            addTradeToTape(trade);
-            executeTrade(best_ask.value(), order, trade);
+            TradePtr trade = shard.trade_factory.createFromLimitOrders(best_ask.value(), order);
+            addTradeToTape(shard, trade);
+            executeTrade(shard, best_ask.value(), order, trade);
 
             best_ask = getOrderBookFor(order->ticker)->bestAsk();
         }
@@ -212,11 +287,9 @@ void StockExchange::matchOrder(LimitOrderPtr order)
 
         while (best_bid.has_value() && !order->isFilled() && order->price <= best_bid.value()->price)
         {
-            getOrderBookFor(order->ticker)->popBestBid();
-
-            TradePtr trade = trade_factory_.createFromLimitOrders(best_bid.value(), order);
-            addTradeToTape(trade);
-            executeTrade(best_bid.value(), order, trade);
+            TradePtr trade = shard.trade_factory.createFromLimitOrders(best_bid.value(), order);
+            addTradeToTape(shard, trade);
+            executeTrade(shard, best_bid.value(), order, trade);
 
             best_bid = getOrderBookFor(order->ticker)->bestBid();
         }
@@ -229,107 +302,63 @@ void StockExchange::matchOrder(LimitOrderPtr order)
     // Cancel the remainder of the order otherwise
     else if (order->time_in_force == Order::TimeInForce::IOC)
     {
-        cancelOrder(order);
+        cancelOrder(shard, order);
     }
 };
 
-void StockExchange::matchOrderInFull(LimitOrderPtr order)
+void StockExchange::matchOrderInFull(ExchangeShard& shard, LimitOrderPtr order)
 {
-    int temp_rem_quantity = order->remaining_quantity;
-    std::stack<LimitOrderPtr> stack;
-
-    if (order->side == Order::Side::BID) {
-        std::optional<LimitOrderPtr> best_ask = getOrderBookFor(order->ticker)->bestAsk();
-        while (best_ask.has_value() && temp_rem_quantity > 0 && order->price >= best_ask.value()->price)
-        {
-            getOrderBookFor(order->ticker)->popBestAsk();
-
-            stack.push(best_ask.value());
-            temp_rem_quantity -= std::min(temp_rem_quantity, best_ask.value()->remaining_quantity);
-
-            best_ask = getOrderBookFor(order->ticker)->bestAsk();
-        }
-    }
-    else
-    {
-        std::optional<LimitOrderPtr> best_bid = getOrderBookFor(order->ticker)->bestBid();
-        while (best_bid.has_value() && temp_rem_quantity > 0 && order->price <= best_bid.value()->price)
-        {
-            getOrderBookFor(order->ticker)->popBestBid();
-
-            stack.push(best_bid.value());
-            temp_rem_quantity -= std::min(temp_rem_quantity, best_bid.value()->remaining_quantity);
-
-            best_bid = getOrderBookFor(order->ticker)->bestBid();
-        }
-    }
-
-    // Cancel the order if not executed in full and add all matching orders back to the order book
-    if (temp_rem_quantity > 0)
+    // Cancel the incoming order if it cannot be executed in full, leaving the order book untouched
+    if (getOrderBookFor(order->ticker)->matchableQuantity(order) < order->remaining_quantity)
     {
-        // Add all matching orders back to the order book
-        while (!stack.empty())
-        {
-            getOrderBookFor(order->ticker)->addOrder(stack.top());
-            stack.pop();
-        }
-        
-        // Cancel the incoming order
-        cancelOrder(order);
+        cancelOrder(shard, order);
     }
     // Execute the order in full
     else
     {
-        while (!stack.empty())
-        {
-            LimitOrderPtr matched_order = stack.top();
-            stack.pop();
-
-            // Execute trade
-            TradePtr trade = trade_factory_.createFromLimitOrders(matched_order, order);
-            addTradeToTape(trade);
-            executeTrade(matched_order, order, trade);
-        }
+        matchOrder(shard, order);
     }
 };
 
-void StockExchange::cancelOrder(OrderPtr order)
+void StockExchange::cancelOrder(ExchangeShard& shard, OrderPtr order)
 {
     order->setStatus(Order::Status::CANCELLED);
-    ExecutionReportMessagePtr report = ExecutionReportMessage::createFromOrder(order);
+    ExecutionReportMessagePtr report = ExecutionReportMessage::createFromOrder(snapshotOrder(shard, order), &shard.execution_report_pool);
     report->sender_id = this->agent_id;
-    sendExecutionReport(std::to_string(order->sender_id), report);
+    sendExecutionReport(shard, std::to_string(order->sender_id), report);
 }
 
-void StockExchange::executeTrade(LimitOrderPtr resting_order, OrderPtr aggressing_order, TradePtr trade)
+void StockExchange::executeTrade(ExchangeShard& shard, LimitOrderPtr resting_order, OrderPtr aggressing_order, TradePtr trade)
 {
-    // Decrement the quantity of the orders by quantity traded
+    // Decrement the quantity of the orders by quantity traded, removing the resting order once filled
     getOrderBookFor(resting_order->ticker)->updateOrderWithTrade(resting_order, trade);
     getOrderBookFor(resting_order->ticker)->updateOrderWithTrade(aggressing_order, trade);
 
-    // Re-insert the resting order if it has not been fully filled
-    if (resting_order->remaining_quantity > 0) {
-        getOrderBookFor(resting_order->ticker)->addOrder(resting_order);
-    }
-
     // Log the trade in the order book
     getOrderBookFor(resting_order->ticker)->logTrade(trade);
 
     // Send execution reports to the traders
-    ExecutionReportMessagePtr resting_report = ExecutionReportMessage::createFromTrade(resting_order, trade);
+    ExecutionReportMessagePtr resting_report = ExecutionReportMessage::createFromTrade(snapshotOrder(shard, resting_order), trade, &shard.execution_report_pool);
     resting_report->sender_id = this->agent_id;
-    ExecutionReportMessagePtr aggressing_report = ExecutionReportMessage::createFromTrade(aggressing_order, trade);
+    ExecutionReportMessagePtr aggressing_report = ExecutionReportMessage::createFromTrade(snapshotOrder(shard, aggressing_order), trade, &shard.execution_report_pool);
     aggressing_report->sender_id = this->agent_id;
-    sendExecutionReport(std::to_string(resting_order->sender_id), resting_report);
-    sendExecutionReport(std::to_string(aggressing_order->sender_id), aggressing_report);
-
-    // Broadcast the market data to all subscribers
-    publishMarketData(resting_order->ticker);
+    sendExecutionReport(shard, std::to_string(resting_order->sender_id), resting_report);
+    sendExecutionReport(shard, std::to_string(aggressing_order->sender_id), aggressing_report);
 }
 
-void StockExchange::sendExecutionReport(std::string_view trader, ExecutionReportMessagePtr msg)
+void StockExchange::sendExecutionReport(ExchangeShard& shard, std::string_view trader, ExecutionReportMessagePtr msg)
 {
-    sendMessageTo(trader, std::dynamic_pointer_cast<Message>(msg), true);
+    shard.pending_reports.push_back({std::string{trader}, std::dynamic_pointer_cast<Message>(msg)});
+};
+
+OrderPtr StockExchange::snapshotOrder(ExchangeShard& shard, OrderPtr order)
+{
+    // Reports are serialised after the batch, once later trades in it may have changed the live order
+    if (order->type == Order::Type::LIMIT)
+    {
+        return shard.limit_order_pool.create(*std::static_pointer_cast<LimitOrder>(order));
+    }
+    return shard.market_order_pool.create(*std::static_pointer_cast<MarketOrder>(order));
 };
 
 std::optional<MessagePtr> StockExchange::handleMessageFrom(std::string_view sender, MessagePtr message)
@@ -342,18 +371,64 @@ std::optional<MessagePtr> StockExchange::handleMessageFrom(std::string_view send
             if (msg == nullptr) {
                 throw std::runtime_error("Failed to cast message to SubscribeMessage");
             }
-            onSubscribe(msg);
-            break;
+            return onSubscribe(msg);
         }
         default:
         {   
-            // Send message to the matching engine
-            msg_queue_.push(message);
+            // Send message to the matching engine of the shard trading its ticker
+            std::optional<ExchangeShardPtr> shard = getShardFor(message);
+            if (shard.has_value())
+            {
+                shard.value()->msg_queue.push(message);
+            }
+            else
+            {
+                LOG_WARN << "Exchange received message for a ticker not traded";
+            }
         }
     }
     return std::nullopt;
 };
 
+std::optional<ExchangeShardPtr> StockExchange::getShardFor(MessagePtr message)
+{
+    std::unordered_map<std::string, size_t>::const_iterator it;
+    switch (message->type)
+    {
+        case MessageType::LIMIT_ORDER:
+        {
+            it = ticker_shards_.find(std::static_pointer_cast<LimitOrderMessage>(message)->ticker);
+            break;
+        }
+        case MessageType::MARKET_ORDER:
+        {
+            it = ticker_shards_.find(std::static_pointer_cast<MarketOrderMessage>(message)->ticker);
+            break;
+        }
+        case MessageType::CANCEL_ORDER:
+        {
+            it = ticker_shards_.find(std::static_pointer_cast<CancelOrderMessage>(message)->ticker);
+            break;
+        }
+        case MessageType::SNAPSHOT_REQUEST:
+        {
+            it = ticker_shards_.find(std::static_pointer_cast<SnapshotRequestMessage>(message)->ticker);
+            break;
+        }
+        default:
+        {
+            // Messages without a ticker are handled by the first shard
+            return shards_.front();
+        }
+    }
+
+    if (it == ticker_shards_.end())
+    {
+        return std::nullopt;
+    }
+    return shards_.at(it->second);
+};
+
 void StockExchange::handleBroadcastFrom(std::string_view sender, MessagePtr message)
 {
     /** TODO: Decide how to handle this more elegantly. */
@@ -361,22 +436,102 @@ void StockExchange::handleBroadcastFrom(std::string_view sender, MessagePtr mess
 };
 
 
-void StockExchange::onSubscribe(SubscribeMessagePtr msg)
+std::optional<MessagePtr> StockExchange::onSubscribe(SubscribeMessagePtr msg)
 {
+    if (msg->depth < 0)
+    {
+        throw std::runtime_error("Failed to add subscriber: Depth " + std::to_string(msg->depth) + " is negative");
+    }
     if (order_books_.contains(std::string{msg->ticker}))
     {
-        std::cout << "Subscription address: " << msg->address << " Agent ID: " << msg->sender_id << "\n";
-        addSubscriber(msg->ticker, msg->sender_id, msg->address);
+        LOG_INFO << "Subscription address: " << msg->address << " Agent ID: " << msg->sender_id;
+        addSubscriber(msg->ticker, msg->sender_id, msg->address, msg->feed, msg->depth);
     }
     else
     {
         throw std::runtime_error("Failed to add subscriber: Ticker " + msg->ticker + " not found");
     }
+
+    // Subscribers to a multicast ticker receive its market data by joining the group
+    auto group = multicast_groups_.find(msg->ticker);
+    if (group == multicast_groups_.end()) return std::nullopt;
+
+    MulticastGroupMessagePtr reply = std::make_shared<MulticastGroupMessage>();
+    reply->sender_id = this->agent_id;
+    reply->ticker = msg->ticker;
+    reply->group = group->second->front().address().to_string() + ":" + std::to_string(group->second->front().port());
+    return std::dynamic_pointer_cast<Message>(reply);
 };
 
-void StockExchange::addSubscriber(std::string_view ticker, int subscriber_id, std::string_view address)
+void StockExchange::onSnapshotRequest(ExchangeShard& shard, SnapshotRequestMessagePtr msg)
 {
-    subscribers_.at(std::string{ticker}).insert({subscriber_id, std::string{address}});
+    if (msg->depth < 0)
+    {
+        LOG_WARN << "Snapshot request with negative depth " << msg->depth << " ignored";
+        return;
+    }
+    TickerFeed& feed = shard.feeds.at(msg->ticker);
+
+    SnapshotMessagePtr snapshot = std::make_shared<SnapshotMessage>();
+    snapshot->sender_id = this->agent_id;
+    snapshot->ticker = msg->ticker;
+    snapshot->feed = msg->feed;
+    snapshot->depth = msg->depth;
+    snapshot->sequence = 0;
+    snapshot->data = feed.order_book->getLiveMarketData();
+
+    if (msg->feed == SubscribeMessage::Feed::LEVEL_2)
+    {
+        // Level 2 streams only change when published, so they match their sequence numbers
+        DepthStream& stream = feed.depth_streams[msg->depth];
+        snapshot->sequence = stream.sequence;
+        if (msg->depth > 0)
+        {
+            snapshot->levels = stream.levels;
+        }
+        else if (stream.sequence > 0)
+        {
+            feed.depth.top(std::numeric_limits<size_t>::max(), snapshot->levels);
+        }
+    }
+    else if (msg->feed == SubscribeMessage::Feed::MARKET_BY_ORDER)
+    {
+        // Order events are numbered when recorded, so the book matches the latest one even if not yet published
+        snapshot->sequence = feed.order_book->orderEventSequence();
+        std::vector<LimitOrderPtr> orders;
+        feed.order_book->collectOrders(Order::Side::BID, orders);
+        feed.order_book->collectOrders(Order::Side::ASK, orders);
+        snapshot->orders.reserve(orders.size());
+        for (LimitOrderPtr const& order : orders)
+        {
+            snapshot->orders.push_back({OrderEvent::Type::ADD, order->side, order->id, order->price, order->remaining_quantity});
+        }
+    }
+
+    shard.pending_reports.push_back({std::to_string(msg->sender_id), std::dynamic_pointer_cast<Message>(snapshot)});
+}
+
+void StockExchange::addSubscriber(std::string_view ticker, int subscriber_id, std::string_view address, SubscribeMessage::Feed feed, int depth)
+{
+    // Replace any previous subscription in place, otherwise insert at a uniformly random position
+    // so that the subscribers stay in a random order without shuffling on every broadcast
+    Subscription subscription {subscriber_id, NetworkEntity::resolveEndpoint(address), feed, depth};
+    std::unique_lock subscribers_lock{subscribers_mutex_};
+    std::vector<Subscription>& subscriptions = subscribers_.at(std::string{ticker});
+    auto it = std::find_if(subscriptions.begin(), subscriptions.end(), [subscriber_id](Subscription const& existing){
+        return existing.subscriber_id == subscriber_id;
+    });
+    if (it != subscriptions.end())
+    {
+        *it = subscription;
+    }
+    else
+    {
+        std::uniform_int_distribution<size_t> position(0, subscriptions.size());
+        subscriptions.insert(subscriptions.begin() + position(random_generator_), subscription);
+    }
+    rebuildSubscriberEndpoints(std::string{ticker});
+    subscribers_lock.unlock();
 
     // If trader connects after trading has started, inform the trader that trading window is open
     std::unique_lock lock {trading_window_mutex_};
@@ -393,13 +548,100 @@ void StockExchange::addSubscriber(std::string_view ticker, int subscriber_id, st
     }
 };
 
+void StockExchange::reportPoolOccupancy() const
+{
+    for (ExchangeShardPtr shard : shards_)
+    {
+        std::ostringstream report;
+        shard->reportPoolOccupancy(report);
+        LOG_INFO << "Shard " << shard->index << " pools:\n" << report.str();
+    }
+};
+
+void StockExchange::reportBroadcastStats()
+{
+    std::ostringstream report;
+    broadcastStats().report(report);
+    LOG_INFO << report.str();
+};
+
+void StockExchange::reportWriteStats()
+{
+    std::ostringstream report;
+    writeStats().report(report);
+    LOG_INFO << report.str();
+};
+
+void StockExchange::createShards(ExchangeConfigPtr config)
+{
+    // Tickers configured with the same shard are grouped, any other ticker gets a shard of its own
+    std::unordered_map<int, size_t> groups;
+    size_t shard_count = 0;
+    for (auto const& ticker : config->tickers)
+    {
+        int group = 0;
+        if (config->sharded)
+        {
+            group = config->ticker_configs.contains(ticker) ? config->ticker_configs.at(ticker).shard : -1;
+        }
+
+        if (group < 0)
+        {
+            ticker_shards_.insert({ticker, shard_count++});
+        }
+        else
+        {
+            auto [it, inserted] = groups.try_emplace(group, shard_count);
+            if (inserted) ++shard_count;
+            ticker_shards_.insert({ticker, it->second});
+        }
+    }
+
+    // Always create one shard so that assets can be added later
+    shard_count = std::max<size_t>(shard_count, 1);
+    for (size_t i = 0; i < shard_count; ++i)
+    {
+        shards_.push_back(std::make_shared<ExchangeShard>(i, shard_count, huge_pages_));
+    }
+
+    // Create message tapes to log incoming messages
+    for (ExchangeShardPtr shard : shards_)
+    {
+        createMessageTape(*shard);
+    }
+    LOG_INFO << "Matching " << config->tickers.size() << " tickers on " << shard_count << " shards";
+};
+
 void StockExchange::addTradeableAsset(std::string_view ticker)
 {
-    order_books_.insert({std::string{ticker}, OrderBook::create(ticker)});
-    subscribers_.insert({std::string{ticker}, {}});
+    addTradeableAsset(TickerConfig{ticker});
+};
 
-    createDataFiles(ticker);
-    std::cout << "Added " << ticker << " as a tradeable asset" << std::endl;
+void StockExchange::addTradeableAsset(TickerConfig const& ticker_config)
+{
+    addTradeableAsset(ticker_config, shards_.front());
+};
+
+void StockExchange::addTradeableAsset(TickerConfig const& ticker_config, ExchangeShardPtr shard)
+{
+    ticker_shards_.insert({ticker_config.ticker, shard->index});
+    shard->tickers.push_back(ticker_config.ticker);
+    order_books_.insert({ticker_config.ticker, OrderBook::create(ticker_config)});
+    shard->feeds.insert({ticker_config.ticker, TickerFeed{getOrderBookFor(ticker_config.ticker), std::chrono::milliseconds(ticker_config.min_publish_interval)}});
+    subscribers_.insert({ticker_config.ticker, {}});
+    subscriber_endpoints_.insert({ticker_config.ticker, TickerEndpoints{std::make_shared<const std::vector<asio::ip::udp::endpoint>>(), {}}});
+    if (!ticker_config.multicast_group.empty())
+    {
+        asio::ip::udp::endpoint group = NetworkEntity::resolveEndpoint(ticker_config.multicast_group);
+        if (!group.address().is_multicast())
+        {
+            throw std::runtime_error("Address " + ticker_config.multicast_group + " of ticker " + ticker_config.ticker + " is not a multicast group");
+        }
+        multicast_groups_.insert({ticker_config.ticker, std::make_shared<const std::vector<asio::ip::udp::endpoint>>(1, group)});
+    }
+
+    createDataFiles(ticker_config.ticker);
+    LOG_INFO << "Added " << ticker_config.ticker << " as a tradeable asset";
 };
 
 void StockExchange::createDataFiles(std::string_view ticker)
@@ -412,18 +654,19 @@ void StockExchange::createDataFiles(std::string_view ticker)
 
     // Set path to CSV files
     std::string suffix = std::string{exchange_name_} + "_" + std::string{ticker} + "_"  + timestamp;
-    std::string trades_file = "trades_" + suffix + ".csv";
-    std::string market_data_file = "data_" + suffix + ".csv";
+    std::string extension = tape_format_ == TapeFormat::BINARY ? ".bin" : ".csv";
+    std::string trades_file = "trades_" + suffix + extension;
+    std::string market_data_file = "data_" + suffix + extension;
 
     // Create a CSV writers
-    CSVWriterPtr trade_writer = std::make_shared<CSVWriter>(trades_file);
-    CSVWriterPtr market_data_writer = std::make_shared<CSVWriter>(market_data_file);
+    CSVWriterPtr trade_writer = std::make_shared<CSVWriter>(trades_file, tape_format_, tape_flush_policy_);
+    CSVWriterPtr market_data_writer = std::make_shared<CSVWriter>(market_data_file, tape_format_, tape_flush_policy_);
 
     trade_tapes_.insert({std::string{ticker}, trade_writer});
     market_data_feeds_.insert({std::string{ticker}, market_data_writer});
 }
 
-void StockExchange::createMessageTape() 
+void StockExchange::createMessageTape(ExchangeShard& shard) 
 {
     // Get current ISO 8601 timestamp
     std::time_t t = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
@@ -433,22 +676,173 @@ void StockExchange::createMessageTape()
 
     // Define CSV filename
     std::string suffix = std::string{exchange_name_} + "_"  + timestamp;
-    std::string messages_file = "msgs_" + suffix + ".csv";
+    if (shards_.size() > 1)
+    {
+        suffix = std::string{exchange_name_} + "_" + std::to_string(shard.index) + "_" + timestamp;
+    }
+    std::string messages_file = "msgs_" + suffix + (tape_format_ == TapeFormat::BINARY ? ".bin" : ".csv");
 
     // Create message writer
-    this->message_tape_ = std::make_shared<CSVWriter>(messages_file);
+    shard.message_tape = std::make_shared<CSVWriter>(messages_file, tape_format_, tape_flush_policy_);
 }
 
-void StockExchange::publishMarketData(std::string_view ticker)
+void StockExchange::publishMarketData(ExchangeShard& shard, std::string_view ticker)
 {
-    MarketDataPtr data = getOrderBookFor(ticker)->getLiveMarketData();
-    addMarketDataSnapshot(data);
+    TickerFeed& feed = shard.feeds.at(std::string{ticker});
+
+    // Nothing subscribers can see has changed since the last snapshot
+    if (feed.order_book->version() == feed.published_version)
+    {
+        return;
+    }
+
+    // Hold back snapshots within the minimum interval, the latest state goes out once it elapses
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (now - feed.last_published < feed.min_publish_interval)
+    {
+        if (!feed.pending)
+        {
+            feed.pending = true;
+            ++shard.pending_feeds;
+        }
+        return;
+    }
+    if (feed.pending)
+    {
+        feed.pending = false;
+        --shard.pending_feeds;
+    }
+    feed.published_version = feed.order_book->version();
+    feed.last_published = now;
+
+    MarketDataPtr data = feed.order_book->getLiveMarketData(shard.batch_timestamp, &shard.market_data_pool);
+    addMarketDataSnapshot(shard, data);
     
-    MarketDataMessagePtr msg = std::make_shared<MarketDataMessage>();
+    MarketDataMessagePtr msg = shard.market_data_message_pool.create();
     msg->data = data;
 
-    // Send message to all subscribers of the given ticker 
-    broadcastToSubscribers(ticker, std::dynamic_pointer_cast<Message>(msg));
+    // Send message to all level 1 subscribers of the given ticker 
+    broadcastToSubscribers(shard, ticker, std::dynamic_pointer_cast<Message>(msg), SubscribeMessage::Feed::LEVEL_1);
+
+    publishMarketDepth(shard, ticker, feed);
+    publishOrderEvents(shard, ticker, feed);
+};
+
+void StockExchange::publishMarketDepth(ExchangeShard& shard, std::string_view ticker, TickerFeed& feed)
+{
+    // Find the depths subscribed to
+    feed.depths.clear();
+    {
+        std::shared_lock lock{subscribers_mutex_};
+        for (FeedEndpoints const& subscribers : subscriber_endpoints_.at(std::string{ticker}).feeds)
+        {
+            if (subscribers.feed == SubscribeMessage::Feed::LEVEL_2)
+            {
+                feed.depths.push_back(subscribers.depth);
+            }
+        }
+    }
+
+    // Streams nobody receives any more would miss updates, so they start afresh once subscribed to again
+    std::erase_if(feed.depth_streams, [&feed](auto const& stream){
+        return std::find(feed.depths.begin(), feed.depths.end(), stream.first) == feed.depths.end();
+    });
+
+    // Without level 2 subscribers the levels are not tracked, and are rebuilt from the book for the next one
+    if (feed.depths.empty())
+    {
+        feed.depth_tracked = false;
+        feed.order_book->clearChangedLevels();
+        return;
+    }
+    feed.book_updates.clear();
+    if (!feed.depth_tracked)
+    {
+        trackMarketDepth(feed);
+    }
+    else
+    {
+        // Bring the published levels up to date, collecting the updates for the full book
+        for (auto const& [side, price] : feed.order_book->changedLevels())
+        {
+            feed.depth.apply(side, price, feed.order_book->levelSize(side, price), feed.book_updates);
+        }
+    }
+    feed.order_book->clearChangedLevels();
+
+    for (int depth : feed.depths)
+    {
+        // A new stream starts with all levels within its depth
+        DepthStream& stream = feed.depth_streams[depth];
+        std::vector<DepthUpdate>* updates = &feed.book_updates;
+        if (depth > 0 || stream.sequence == 0)
+        {
+            feed.updates.clear();
+            feed.depth.top(depth == 0 ? std::numeric_limits<size_t>::max() : depth, feed.levels);
+            MarketDepth::diff(stream.levels, feed.levels, feed.updates);
+            if (depth > 0) stream.levels.swap(feed.levels);
+            updates = &feed.updates;
+        }
+
+        // Split the updates into messages that each fit in a datagram
+        for (size_t first = 0; first < updates->size(); first += MarketDepthMessage::MAX_UPDATES)
+        {
+            size_t last = std::min(first + MarketDepthMessage::MAX_UPDATES, updates->size());
+            MarketDepthMessagePtr msg = shard.market_depth_message_pool.create();
+            msg->ticker = ticker;
+            msg->depth = depth;
+            msg->sequence = ++stream.sequence;
+            msg->updates.assign(updates->begin() + first, updates->begin() + last);
+            broadcastToSubscribers(shard, ticker, std::dynamic_pointer_cast<Message>(msg), SubscribeMessage::Feed::LEVEL_2, depth);
+        }
+    }
+}
+
+void StockExchange::trackMarketDepth(TickerFeed& feed)
+{
+    feed.depth.clear();
+    std::vector<LimitOrderPtr> orders;
+    feed.order_book->collectOrders(Order::Side::BID, orders);
+    feed.order_book->collectOrders(Order::Side::ASK, orders);
+    for (LimitOrderPtr const& order : orders)
+    {
+        feed.depth.apply(order->side, order->price, feed.order_book->levelSize(order->side, order->price), feed.book_updates);
+    }
+    feed.book_updates.clear();
+    feed.depth_tracked = true;
+}
+
+void StockExchange::publishOrderEvents(ExchangeShard& shard, std::string_view ticker, TickerFeed& feed)
+{
+    std::vector<OrderEvent> const& events = feed.order_book->orderEvents();
+    unsigned long long sequence = feed.order_book->orderEventSequence() - events.size();
+    std::shared_lock lock{subscribers_mutex_};
+    std::vector<FeedEndpoints> const& feeds = subscriber_endpoints_.at(std::string{ticker}).feeds;
+    bool subscribed = std::any_of(feeds.begin(), feeds.end(), [](FeedEndpoints const& subscribers){
+        return subscribers.feed == SubscribeMessage::Feed::MARKET_BY_ORDER;
+    });
+    lock.unlock();
+
+    // Split the events into messages that each fit in a datagram
+    for (size_t first = 0; subscribed && first < events.size(); first += MarketByOrderMessage::MAX_EVENTS)
+    {
+        size_t last = std::min(first + MarketByOrderMessage::MAX_EVENTS, events.size());
+        MarketByOrderMessagePtr msg = shard.market_by_order_message_pool.create();
+        msg->ticker = ticker;
+        msg->sequence = sequence + first + 1;
+        msg->setEvents(events.begin() + first, events.begin() + last);
+        broadcastToSubscribers(shard, ticker, std::dynamic_pointer_cast<Message>(msg), SubscribeMessage::Feed::MARKET_BY_ORDER);
+    }
+    feed.order_book->clearOrderEvents();
+}
+
+void StockExchange::publishPendingMarketData(ExchangeShard& shard)
+{
+    for (auto const& [ticker, feed] : shard.feeds)
+    {
+        if (shard.pending_feeds == 0) break;
+        if (feed.pending) publishMarketData(shard, ticker);
+    }
 };
 
 void StockExchange::setTradingWindow(int connect_time, int trading_time)
@@ -461,18 +855,18 @@ void StockExchange::setTradingWindow(int connect_time, int trading_time)
     trading_window_thread_ = new std::thread([=, this](){
 
         // Allow time for connections
-        std::cout << "Trading time set to " << trading_time << " seconds." << std::endl;
-        std::cout << "Waiting for connections for " << connect_time << " seconds..." << std::endl;
+        LOG_INFO << "Trading time set to " << trading_time << " seconds.";
+        LOG_INFO << "Waiting for connections for " << connect_time << " seconds...";
         std::this_thread::sleep_for(std::chrono::seconds(connect_time));
 
         // Start trading session 
-        std::cout << "Trading session starts now" << std::endl;
+        LOG_INFO << "Trading session starts now";
         startTradingSession();
         std::this_thread::sleep_for(std::chrono::seconds(trading_time));
 
         // End trading session
         endTradingSession();
-        std::cout << "Trading session ended.\n";
+        LOG_INFO << "Trading session ended.";
     });
 }
 
@@ -480,7 +874,7 @@ void StockExchange::startTradingSession()
 {
     // Signal start of trading window to the matching engine
     std::unique_lock<std::mutex> trading_window_lock(trading_window_mutex_);
-    trading_window_open_ = true;
+    trading_window_open_.store(true, std::memory_order_release);
     trading_window_lock.unlock();
     trading_window_cv_.notify_all();
 
@@ -497,16 +891,17 @@ void StockExchange::endTradingSession()
 {
     // Signal end of trading window to the matching engine
     std::unique_lock<std::mutex> trading_window_lock(trading_window_mutex_);
-    trading_window_open_ = false;
-    msg_queue_.close();
+    trading_window_open_.store(false, std::memory_order_release);
+    for (ExchangeShardPtr shard : shards_)
+    {
+        shard->msg_queue.close();
+    }
     trading_window_lock.unlock();
     trading_window_cv_.notify_all();
 
-    // Iterate through all tickers and close all open csv files
-    for (auto const& [ticker, writer] : trade_tapes_)
-    {
-        writer->stop();
-    }
+    reportPoolOccupancy();
+    reportBroadcastStats();
+    reportWriteStats();
 
     EventMessagePtr msg = std::make_shared<EventMessage>(EventMessage::EventType::TRADING_SESSION_END);
 
@@ -532,32 +927,87 @@ CSVWriterPtr StockExchange::getMarketDataFeedFor(std::string_view ticker)
     return market_data_feeds_.at(std::string{ticker});
 };
 
-void StockExchange::addTradeToTape(TradePtr trade)
+void StockExchange::addTradeToTape(ExchangeShard& shard, TradePtr trade)
 {
-    std::cout << *trade << "\n";
-    getTradeTapeFor(trade->ticker)->writeRow(trade);
+    LOG_DEBUG << *trade;
+    shard.pending_rows[getTradeTapeFor(trade->ticker)].push_back(trade);
 };
 
-void StockExchange::addMarketDataSnapshot(MarketDataPtr data)
+void StockExchange::addMarketDataSnapshot(ExchangeShard& shard, MarketDataPtr data)
+{
+    shard.pending_rows[getMarketDataFeedFor(data->ticker)].push_back(data);
+}
+
+void StockExchange::addMessageToTape(ExchangeShard& shard, MessagePtr msg)
 {
-    getMarketDataFeedFor(data->ticker)->writeRow(data);
+    shard.pending_rows[shard.message_tape].push_back(msg);
 }
 
-void StockExchange::addMessageToTape(MessagePtr msg)
+void StockExchange::broadcastToSubscribers(ExchangeShard& shard, std::string_view ticker, MessagePtr msg, SubscribeMessage::Feed feed, int depth)
 {
-    message_tape_->writeRow(msg);
+    std::shared_lock lock{subscribers_mutex_};
+    TickerEndpoints const& subscribers = subscriber_endpoints_.at(std::string{ticker});
+    if (subscribers.all->empty()) return;
+
+    // Multicast tickers are published once whatever the number of subscribers, who each pick out their own feed
+    auto group = multicast_groups_.find(std::string{ticker});
+    if (group != multicast_groups_.end())
+    {
+        shard.pending_broadcasts.push_back({msg, group->second});
+        return;
+    }
+
+    // Queue a single broadcast sharing the feed's endpoint list, sent with the rest of the batch. It starts one place
+    // further along the random order each time, so no subscriber is always served first
+    for (FeedEndpoints const& feed_subscribers : subscribers.feeds)
+    {
+        if (feed_subscribers.feed == feed && (feed != SubscribeMessage::Feed::LEVEL_2 || feed_subscribers.depth == depth))
+        {
+            size_t start = shard.broadcast_rotation++ % feed_subscribers.endpoints->size();
+            shard.pending_broadcasts.push_back({msg, feed_subscribers.endpoints, start});
+            return;
+        }
+    }
 }
 
 void StockExchange::broadcastToSubscribers(std::string_view ticker, MessagePtr msg)
 {
-    // Randomise the subscribers list
-    std::unordered_map<int, std::string> ticker_subcribers(subscribers_.at(std::string{ticker}));
-    std::vector<std::pair<int, std::string>> randomised_subscribers(ticker_subcribers.begin(), ticker_subcribers.end());
-    std::shuffle(randomised_subscribers.begin(), randomised_subscribers.end(), random_generator_);
+    std::shared_lock lock{subscribers_mutex_};
+    EndpointList subscribers = subscriber_endpoints_.at(std::string{ticker}).all;
+    if (subscribers->empty()) return;
 
-    // Send a broadcast to each one
-    for (auto const& [subscriber_id, address] : randomised_subscribers)
+    auto group = multicast_groups_.find(std::string{ticker});
+    sendBroadcast(group != multicast_groups_.end() ? group->second : subscribers, msg);
+}
+
+void StockExchange::rebuildSubscriberEndpoints(std::string const& ticker)
+{
+    std::vector<asio::ip::udp::endpoint> all;
+    std::vector<std::tuple<SubscribeMessage::Feed, int, std::vector<asio::ip::udp::endpoint>>> feeds;
+    for (Subscription const& subscription : subscribers_.at(ticker))
     {
-        sendBroadcast(address, std::dynamic_pointer_cast<Message>(msg));
+        all.push_back(subscription.endpoint);
+
+        // Only level 2 streams differ by depth
+        int depth = subscription.feed == SubscribeMessage::Feed::LEVEL_2 ? subscription.depth : 0;
+        auto feed = std::find_if(feeds.begin(), feeds.end(), [&subscription, depth](auto const& feed){
+            return std::get<0>(feed) == subscription.feed && std::get<1>(feed) == depth;
+        });
+        if (feed == feeds.end())
+        {
+            feeds.push_back({subscription.feed, depth, {subscription.endpoint}});
+        }
+        else
+        {
+            std::get<2>(*feed).push_back(subscription.endpoint);
+        }
     }
-}
\ No newline at end of file
+
+    TickerEndpoints& endpoints = subscriber_endpoints_.at(ticker);
+    endpoints.all = std::make_shared<const std::vector<asio::ip::udp::endpoint>>(std::move(all));
+    endpoints.feeds.clear();
+    for (auto& [feed, depth, feed_endpoints] : feeds)
+    {
+        endpoints.feeds.push_back({feed, depth, std::make_shared<const std::vector<asio::ip::udp::endpoint>>(std::move(feed_endpoints))});
+    }
+}
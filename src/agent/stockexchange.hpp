@@ -2,19 +2,25 @@
 #define STOCK_EXCHANGE_HPP
 
 #include <random>
+#include <shared_mutex>
 
 #include "../agent/agent.hpp"
+#include "../agent/exchangeshard.hpp"
 #include "../config/exchangeconfig.hpp"
 #include "../order/order.hpp"
 #include "../order/orderbook.hpp"
 #include "../order/orderfactory.hpp"
 #include "../trade/trade.hpp"
 #include "../trade/tradefactory.hpp"
-#include "../utilities/syncqueue.hpp"
 #include "../utilities/csvwriter.hpp"
 #include "../utilities/csvprintable.hpp"
 #include "../message/message.hpp"
 #include "../message/market_data_message.hpp"
+#include "../message/market_depth_message.hpp"
+#include "../message/market_by_order_message.hpp"
+#include "../message/snapshot_request_message.hpp"
+#include "../message/snapshot_message.hpp"
+#include "../message/multicast_group_message.hpp"
 #include "../message/limit_order_message.hpp"
 #include "../message/market_order_message.hpp"
 #include "../message/cancel_order_message.hpp"
@@ -30,20 +36,25 @@ public:
     StockExchange(NetworkEntity *network_entity, ExchangeConfigPtr config)
     : Agent(network_entity, std::static_pointer_cast<AgentConfig>(config)),
       exchange_name_{config->name},
+      huge_pages_{config->huge_pages},
+      tape_format_{config->tape_format},
+      tape_flush_policy_{config->tape_buffer_size, std::chrono::milliseconds{config->tape_flush_interval}},
+      shards_{},
+      ticker_shards_{},
       order_books_{},
       subscribers_{},
+      subscriber_endpoints_{},
+      multicast_groups_{},
       trade_tapes_{},
       market_data_feeds_{},
-      msg_queue_{},
       random_generator_{std::random_device{}()}
     {
-      // Create message tape to log incoming messages
-      createMessageTape();
-
-      // Add all tickers to exchange
+      // Add all tickers to exchange, matching them on one shard unless sharding is enabled
+      createShards(config);
       for (auto ticker : config->tickers)
       {
-        addTradeableAsset(ticker);
+        TickerConfig ticker_config = config->ticker_configs.contains(ticker) ? config->ticker_configs.at(ticker) : TickerConfig{ticker};
+        addTradeableAsset(ticker_config, shards_.at(ticker_shards_.at(ticker)));
       }
 
       // Set trading window
@@ -59,6 +70,12 @@ public:
     /** Adds the given asset as tradeable and initialises an empty order book. */
     void addTradeableAsset(std::string_view ticker);
 
+    /** Adds the given asset as tradeable and initialises an empty order book with the configured backend. */
+    void addTradeableAsset(TickerConfig const& ticker_config);
+
+    /** Adds the given asset as tradeable on the given shard and initialises an empty order book. */
+    void addTradeableAsset(TickerConfig const& ticker_config, ExchangeShardPtr shard);
+
     /** Waits for incoming connections then opens trading window for the specified duration (seconds). */
     void setTradingWindow(int connect_time, int trading_time);
 
@@ -77,8 +94,20 @@ public:
     /** Returns the market data feed for the given ticker. */
     CSVWriterPtr getMarketDataFeedFor(std::string_view ticker);
 
-    /** Adds the given subscriber to the market data subscribers list. */
-    void addSubscriber(std::string_view ticker, int subscriber_id, std::string_view address);
+    /** Adds the given subscriber to the market data subscribers list, replacing its previous subscription to the ticker. */
+    void addSubscriber(std::string_view ticker, int subscriber_id, std::string_view address, SubscribeMessage::Feed feed = SubscribeMessage::Feed::LEVEL_1, int depth = 0);
+
+    /** Rebuilds the endpoint lists of the given ticker's subscribers. Called with the subscribers mutex held. */
+    void rebuildSubscriberEndpoints(std::string const& ticker);
+
+    /** Logs the occupancy of the object pools used by the matching engine. */
+    void reportPoolOccupancy() const;
+
+    /** Logs the fan-out timings of the market data broadcasts. */
+    void reportBroadcastStats();
+
+    /** Logs how many execution reports and other messages were gathered into each TCP write. */
+    void reportWriteStats();
 
 private:
 
@@ -86,52 +115,85 @@ private:
      *   HELPER METHODS
     */
 
-    /** Runs the matching engine. */
-    void runMatchingEngine();
+    /** Creates the matching shards and assigns each configured ticker to one of them. */
+    void createShards(ExchangeConfigPtr config);
+
+    /** Returns the shard matching the ticker of the given order message, if the ticker is traded. */
+    std::optional<ExchangeShardPtr> getShardFor(MessagePtr message);
+
+    /** Runs the matching engine of the given shard, matching inbound messages in batches. */
+    void runMatchingEngine(ExchangeShardPtr shard);
+
+    /** Matches a single inbound message and logs it to the message tape. */
+    void processMessage(ExchangeShard& shard, MessagePtr msg);
+
+    /** Sends the reports and market data produced by the shard's current batch and writes its tape rows. */
+    void flushBatch(ExchangeShard& shard);
 
     /** Checks if the given order crosses the spread. */
     bool crossesSpread(LimitOrderPtr order);
 
     /** Matches the given order with the orders currently present in the OrderBook.
      *  Partial execution is allowed. */
-    void matchOrder(LimitOrderPtr order);
+    void matchOrder(ExchangeShard& shard, LimitOrderPtr order);
 
     /** Matches the given order with the orders currently present in the OrderBook. 
      *  Order must be executed in full. */
-    void matchOrderInFull(LimitOrderPtr order);
+    void matchOrderInFull(ExchangeShard& shard, LimitOrderPtr order);
 
     /** Cancels the given order and sends a cancellation report to the sender. */
-    void cancelOrder(OrderPtr order);
+    void cancelOrder(ExchangeShard& shard, OrderPtr order);
 
     /** Executes the trade between the resting and aggressing orders. */
-    void executeTrade(LimitOrderPtr resting_order, OrderPtr aggressing_order, TradePtr trade);
+    void executeTrade(ExchangeShard& shard, LimitOrderPtr resting_order, OrderPtr aggressing_order, TradePtr trade);
 
     /** Adds the given trade to the trade tape. */
-    void addTradeToTape(TradePtr trade);
+    void addTradeToTape(ExchangeShard& shard, TradePtr trade);
 
     /** Creates new trade tape and market data feed CSV files. */
     void createDataFiles(std::string_view ticker);
 
     /** Logs the given market data snapshot. */
-    void addMarketDataSnapshot(MarketDataPtr data);
+    void addMarketDataSnapshot(ExchangeShard& shard, MarketDataPtr data);
 
-    /** Creates a new message tape CSV file. */
-    void createMessageTape();
+    /** Creates a new message tape CSV file for the given shard. */
+    void createMessageTape(ExchangeShard& shard);
 
-    /** Adds the given message to the message tape. */
-    void addMessageToTape(MessagePtr msg);
+    /** Adds the given message to the message tape of the given shard. */
+    void addMessageToTape(ExchangeShard& shard, MessagePtr msg);
 
     /**
      *   MESSAGE SENDERS
     */
 
-    /** Sends execution report to the trader. */
-    void sendExecutionReport(std::string_view trader, ExecutionReportMessagePtr msg);
+    /** Queues an execution report to the trader, sent at the end of the batch. */
+    void sendExecutionReport(ExchangeShard& shard, std::string_view trader, ExecutionReportMessagePtr msg);
+
+    /** Returns a pooled copy of the order, so reports keep its state when they were created. */
+    OrderPtr snapshotOrder(ExchangeShard& shard, OrderPtr order);
+
+    /** Publishes a market data snapshot to all subscribers if the order book changed since the last one,
+     *  holding it back while within the ticker's minimum publish interval. */
+    void publishMarketData(ExchangeShard& shard, std::string_view ticker);
 
-    /** Publishes market data to all subscribers. */
-    void publishMarketData(std::string_view ticker);
+    /** Publishes the snapshots held back by the shard whose minimum publish interval has elapsed. */
+    void publishPendingMarketData(ExchangeShard& shard);
 
-    /** Broadcasts the given message to all subscribers of the given ticker. */
+    /** Publishes the price levels changed since the last update to the level 2 subscribers of each depth. */
+    void publishMarketDepth(ExchangeShard& shard, std::string_view ticker, TickerFeed& feed);
+
+    /** Rebuilds the published levels of the feed from its order book, for its first level 2 subscriber. */
+    void trackMarketDepth(TickerFeed& feed);
+
+    /** Publishes the order events since the last update to the market by order subscribers. */
+    void publishOrderEvents(ExchangeShard& shard, std::string_view ticker, TickerFeed& feed);
+
+    /** Queues a broadcast of the given message to the subscribers of the given ticker's feed, starting one
+     *  place further along their random order each time. Level 2 messages only go to the subscribers of the given depth.
+     *  Multicast tickers queue a single broadcast to their group instead. */
+    void broadcastToSubscribers(ExchangeShard& shard, std::string_view ticker, MessagePtr msg, SubscribeMessage::Feed feed, int depth = 0);
+
+    /** Broadcasts the given message to all subscribers of the given ticker in their random order, or to its multicast group. */
     void broadcastToSubscribers(std::string_view ticker, MessagePtr msg);
 
     /**
@@ -139,16 +201,20 @@ private:
     */
 
     /** Handles a market order message. Immediate or Cancel (IOC) orders only. */
-    void onMarketOrder(MarketOrderMessagePtr msg);
+    void onMarketOrder(ExchangeShard& shard, MarketOrderMessagePtr msg);
 
     /** Handles a limit order message. */
-    void onLimitOrder(LimitOrderMessagePtr msg);
+    void onLimitOrder(ExchangeShard& shard, LimitOrderMessagePtr msg);
 
     /** Handles a cancel order message. */
-    void onCancelOrder(CancelOrderMessagePtr msg);
+    void onCancelOrder(ExchangeShard& shard, CancelOrderMessagePtr msg);
 
-    /** Handles a subscription to market data request message. */
-    void onSubscribe(SubscribeMessagePtr msg);
+    /** Handles a subscription to market data request message. Returns the group to join if the ticker is published by multicast. */
+    std::optional<MessagePtr> onSubscribe(SubscribeMessagePtr msg);
+
+    /** Sends the requested snapshot of a book to the sender. Taken between inbound messages, the
+     *  book is copied on the matching thread and serialised by the network thread. */
+    void onSnapshotRequest(ExchangeShard& shard, SnapshotRequestMessagePtr msg);
 
     /** Checks the type of the incoming message and makes a callback. */
     std::optional<MessagePtr> handleMessageFrom(std::string_view sender, MessagePtr message) override;
@@ -163,6 +229,21 @@ private:
     /** The unique name of the exchange*/
     std::string exchange_name_;
 
+    /** Whether the shards' object pools are backed by huge pages. */
+    bool huge_pages_;
+
+    /** The file format of the trade tapes, market data feeds and message tapes. */
+    TapeFormat tape_format_;
+
+    /** When the tapes write their buffered rows to disk. */
+    CSVFlushPolicy tape_flush_policy_;
+
+    /** Shards each matching a group of tickers on their own thread, declared first to outlive the order books. */
+    std::vector<ExchangeShardPtr> shards_;
+
+    /** Index of the shard matching each ticker traded. */
+    std::unordered_map<std::string, size_t> ticker_shards_;
+
     /** Order books for each ticker traded. */
     std::unordered_map<std::string, OrderBookPtr> order_books_;
 
@@ -172,26 +253,49 @@ private:
     /** Market data feed snapshots for each ticker traded. */
     std::unordered_map<std::string, CSVWriterPtr> market_data_feeds_;
 
-    /** Message tape for each message received. */
-    CSVWriterPtr message_tape_;
+    /** The resolved endpoint of a subscriber and the market data feed it receives. */
+    struct Subscription
+    {
+        int subscriber_id;
+        asio::ip::udp::endpoint endpoint;
+        SubscribeMessage::Feed feed;
+        int depth;
+    };
+
+    /** Subscriptions to each ticker traded, kept in a uniformly random order. The tickers are fixed once
+     *  configured, while the subscriptions change under the mutex as IO threads handle new subscribers. */
+    std::unordered_map<std::string, std::vector<Subscription>> subscribers_;
+    std::shared_mutex subscribers_mutex_;
+
+    /** Endpoints of the subscribers to one feed of a ticker, and depth for level 2, in the subscriptions' order. */
+    struct FeedEndpoints
+    {
+        SubscribeMessage::Feed feed;
+        int depth;
+        EndpointList endpoints;
+    };
 
-    /** Subscribers for each ticker traded. */
-    std::unordered_map<std::string, std::unordered_map<int, std::string>> subscribers_;
+    /** Endpoints of all subscribers to a ticker and of those to each of its feeds. */
+    struct TickerEndpoints
+    {
+        EndpointList all;
+        std::vector<FeedEndpoints> feeds;
+    };
 
-    /** Thread-safe FIFO queue for incoming messages to be processed by the matching engine. */
-    SyncQueue<MessagePtr> msg_queue_;
+    /** Endpoint lists of each ticker's subscribers, rebuilt under the subscribers mutex whenever a subscription
+     *  changes, so publishing only shares them. */
+    std::unordered_map<std::string, TickerEndpoints> subscriber_endpoints_;
 
-    OrderFactory order_factory_;
-    TradeFactory trade_factory_;
+    /** Multicast group of each ticker whose market data is published once to the group, as a list of one endpoint. */
+    std::unordered_map<std::string, EndpointList> multicast_groups_;
 
     /** Conditional variable signalling whether trading window is open */
-    bool trading_window_open_ = false;
+    std::atomic<bool> trading_window_open_ = false;
     std::mutex trading_window_mutex_;
     std::condition_variable trading_window_cv_;
     std::thread* trading_window_thread_ = nullptr;
-    std::thread* matching_engine_thread_ = nullptr;
 
-    /** Used for randomising the order of UDP broadcasts */
+    /** Used for randomising the order of subscribers */
     std::mt19937 random_generator_;
 };
 
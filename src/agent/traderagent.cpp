@@ -1,5 +1,6 @@
 #include <iostream>
 #include <optional>
+#include <algorithm>
 
 #include "traderagent.hpp"
 
@@ -15,6 +16,33 @@ void TraderAgent::terminate()
 
 std::optional<MessagePtr> TraderAgent::handleMessageFrom(std::string_view sender, MessagePtr message)
 {
+    // Snapshots are only requested while the trading window is open
+    if (message->type == MessageType::SNAPSHOT)
+    {
+        SnapshotMessagePtr msg = std::dynamic_pointer_cast<SnapshotMessage>(message);
+        if (msg == nullptr) {
+            throw std::runtime_error("Failed to cast message to SnapshotMessage");
+        }
+        std::vector<MessagePtr> updates = onSnapshotReceived(sender, msg);
+        onSnapshot(sender, msg);
+        for (MessagePtr const& update : updates)
+        {
+            deliverUpdate(sender, update);
+        }
+        return std::nullopt;
+    }
+
+    // Groups are joined as soon as subscribed, so that no market data is missed once trading starts
+    if (message->type == MessageType::MULTICAST_GROUP)
+    {
+        MulticastGroupMessagePtr msg = std::dynamic_pointer_cast<MulticastGroupMessage>(message);
+        if (msg == nullptr) {
+            throw std::runtime_error("Failed to cast message to MulticastGroupMessage");
+        }
+        joinMulticastGroup(msg->group);
+        return std::nullopt;
+    }
+
     // If trading window (for this trader) not yet open ignore message
     std::unique_lock lock{mutex_};
     if (!trading_window_open_) return std::nullopt;
@@ -42,7 +70,7 @@ std::optional<MessagePtr> TraderAgent::handleMessageFrom(std::string_view sender
         }
         default:
         {
-            std::cout << "Unknown message type" << "\n";
+            LOG_WARN << "Unknown message type";
             break;
         }
     }
@@ -65,9 +93,46 @@ void TraderAgent::handleBroadcastFrom(std::string_view sender, MessagePtr messag
             if (msg == nullptr) {
                 throw std::runtime_error("Failed to cast message to MarketDataMessage");
             }
+
+            // Only level 1 subscribers take snapshots from a multicast group carrying all feeds
+            if (isSequenced(sender, msg->data->ticker)) return;
             onMarketData(sender, msg);
             break;
         }
+        case MessageType::MARKET_DEPTH: 
+        {
+            // If trading window (for this trader) not yet open ignore message
+            std::unique_lock lock{mutex_};
+            if (!trading_window_open_) return;
+            lock.unlock();
+
+            MarketDepthMessagePtr msg = std::dynamic_pointer_cast<MarketDepthMessage>(message);
+            if (msg == nullptr) {
+                throw std::runtime_error("Failed to cast message to MarketDepthMessage");
+            }
+            for (MessagePtr const& update : sequenceUpdate(sender, msg->ticker, message))
+            {
+                deliverUpdate(sender, update);
+            }
+            break;
+        }
+        case MessageType::MARKET_BY_ORDER: 
+        {
+            // If trading window (for this trader) not yet open ignore message
+            std::unique_lock lock{mutex_};
+            if (!trading_window_open_) return;
+            lock.unlock();
+
+            MarketByOrderMessagePtr msg = std::dynamic_pointer_cast<MarketByOrderMessage>(message);
+            if (msg == nullptr) {
+                throw std::runtime_error("Failed to cast message to MarketByOrderMessage");
+            }
+            for (MessagePtr const& update : sequenceUpdate(sender, msg->ticker, message))
+            {
+                deliverUpdate(sender, update);
+            }
+            break;
+        }
         case MessageType::EVENT:
         {
             EventMessagePtr msg = std::dynamic_pointer_cast<EventMessage>(message);
@@ -87,19 +152,49 @@ void TraderAgent::handleBroadcastFrom(std::string_view sender, MessagePtr messag
         }
         default:
         {
-            std::cout << "Unknown message type" << "\n";
+            LOG_WARN << "Unknown message type";
             break;
         }
     }
 }
 
-void TraderAgent::subscribeToMarket(std::string_view exchange, std::string_view ticker)
+void TraderAgent::subscribeToMarket(std::string_view exchange, std::string_view ticker, SubscribeMessage::Feed feed, int depth)
 {
     SubscribeMessagePtr msg = std::make_shared<SubscribeMessage>();
     msg->ticker = std::string{ticker};
+    msg->feed = feed;
+    msg->depth = depth;
     msg->address = myAddr() + std::string{":"} + std::to_string(myPort());
 
     Agent::sendMessageTo(exchange, std::dynamic_pointer_cast<Message>(msg));
+
+    // Level 2 and market by order updates are sequenced on top of a snapshot, taken once trading starts
+    std::unique_lock lock{feed_mutex_};
+    std::pair<std::string, std::string> key {std::string{exchange}, std::string{ticker}};
+    if (feed == SubscribeMessage::Feed::LEVEL_1)
+    {
+        feed_recovery_.erase(key);
+        return;
+    }
+    FeedRecovery& recovery = feed_recovery_[key];
+    recovery = FeedRecovery{feed, depth};
+
+    std::unique_lock window_lock{mutex_};
+    if (trading_window_open_)
+    {
+        window_lock.unlock();
+        resynchronise(exchange, ticker, recovery);
+    }
+}
+
+void TraderAgent::requestSnapshot(std::string_view exchange, std::string_view ticker, SubscribeMessage::Feed feed, int depth)
+{
+    SnapshotRequestMessagePtr msg = std::make_shared<SnapshotRequestMessage>();
+    msg->ticker = std::string{ticker};
+    msg->feed = feed;
+    msg->depth = depth;
+
+    Agent::sendMessageTo(exchange, std::dynamic_pointer_cast<Message>(msg));
 }
 
 void TraderAgent::placeLimitOrder(std::string_view exchange, Order::Side side, std::string_view ticker, int quantity, double price, double priv_value, Order::TimeInForce time_in_force, int client_order_id)
@@ -108,7 +203,7 @@ void TraderAgent::placeLimitOrder(std::string_view exchange, Order::Side side, s
     msg->client_order_id = client_order_id;
     msg->ticker = std::string{ticker};;
     msg->quantity = quantity;
-    msg->price = price;
+    msg->price = Price::fromDouble(price);
     msg->side = side;
     msg->priv_value = priv_value;
     msg->time_in_force = time_in_force;
@@ -147,15 +242,160 @@ void TraderAgent::signalTradingStart()
     delay_thread_ = new std::thread([&](){
         if (start_delay_in_seconds_ > 0) 
         {
-            std::cout << "Delayed trader start: waiting " << start_delay_in_seconds_ << " to start...\n";
+            LOG_INFO << "Delayed trader start: waiting " << start_delay_in_seconds_ << " to start...";
             std::this_thread::sleep_for(std::chrono::seconds(start_delay_in_seconds_));
         }
 
-        std::cout << "Trader starts now.\n";
+        LOG_INFO << "Trader starts now.";
         onTradingStart();
 
         std::unique_lock lock{mutex_};
         trading_window_open_ = true;
         lock.unlock();
+
+        // Updates are only received from now on, so start every sequenced subscription from a snapshot
+        std::unique_lock feed_lock{feed_mutex_};
+        for (auto& [key, recovery] : feed_recovery_)
+        {
+            resynchronise(key.first, key.second, recovery);
+        }
     });
+}
+
+void TraderAgent::resynchronise(std::string_view exchange, std::string_view ticker, FeedRecovery& recovery)
+{
+    recovery.synchronised = false;
+    recovery.buffered.clear();
+    if (!recovery.snapshot_requested)
+    {
+        recovery.snapshot_requested = true;
+        requestSnapshot(exchange, ticker, recovery.feed, recovery.depth);
+    }
+}
+
+std::vector<MessagePtr> TraderAgent::onSnapshotReceived(std::string_view exchange, SnapshotMessagePtr msg)
+{
+    std::vector<MessagePtr> ready;
+    std::unique_lock lock{feed_mutex_};
+    auto it = feed_recovery_.find({std::string{exchange}, msg->ticker});
+    if (it == feed_recovery_.end() || it->second.synchronised || it->second.feed != msg->feed || it->second.depth != msg->depth)
+    {
+        return ready;
+    }
+
+    // Resume from the snapshot, replaying the updates received while waiting for it
+    FeedRecovery& recovery = it->second;
+    recovery.synchronised = true;
+    recovery.snapshot_requested = false;
+    recovery.next_sequence = msg->sequence + 1;
+
+    std::deque<MessagePtr> buffered;
+    buffered.swap(recovery.buffered);
+    std::stable_sort(buffered.begin(), buffered.end(), [](MessagePtr const& a, MessagePtr const& b){
+        return sequenceRange(a).first < sequenceRange(b).first;
+    });
+    for (MessagePtr const& update : buffered)
+    {
+        applyUpdate(exchange, msg->ticker, recovery, update, ready);
+    }
+    return ready;
+}
+
+std::vector<MessagePtr> TraderAgent::sequenceUpdate(std::string_view exchange, std::string_view ticker, MessagePtr msg)
+{
+    std::vector<MessagePtr> ready;
+    std::unique_lock lock{feed_mutex_};
+    auto it = feed_recovery_.find({std::string{exchange}, std::string{ticker}});
+    if (it != feed_recovery_.end() && isPartOf(it->second, msg))
+    {
+        applyUpdate(exchange, ticker, it->second, msg, ready);
+    }
+    return ready;
+}
+
+bool TraderAgent::isSequenced(std::string_view exchange, std::string_view ticker)
+{
+    std::unique_lock lock{feed_mutex_};
+    return feed_recovery_.contains({std::string{exchange}, std::string{ticker}});
+}
+
+bool TraderAgent::isPartOf(FeedRecovery const& recovery, MessagePtr msg)
+{
+    switch (msg->type)
+    {
+        case MessageType::MARKET_DEPTH:
+        {
+            return recovery.feed == SubscribeMessage::Feed::LEVEL_2 && recovery.depth == std::static_pointer_cast<MarketDepthMessage>(msg)->depth;
+        }
+        case MessageType::MARKET_BY_ORDER:
+        {
+            return recovery.feed == SubscribeMessage::Feed::MARKET_BY_ORDER;
+        }
+        default:
+        {
+            return false;
+        }
+    }
+}
+
+void TraderAgent::applyUpdate(std::string_view exchange, std::string_view ticker, FeedRecovery& recovery, MessagePtr msg, std::vector<MessagePtr>& ready)
+{
+    if (!recovery.synchronised)
+    {
+        recovery.buffered.push_back(msg);
+        if (recovery.buffered.size() > MAX_BUFFERED_UPDATES)
+        {
+            recovery.buffered.pop_front();
+        }
+        return;
+    }
+
+    auto [first, last] = sequenceRange(msg);
+    if (last < recovery.next_sequence)
+    {
+        // Already part of the snapshot
+        return;
+    }
+    if (first > recovery.next_sequence)
+    {
+        LOG_WARN << "Lost " << ticker << " updates " << recovery.next_sequence << " to " << first - 1 << " from " << exchange << ", resynchronising";
+        resynchronise(exchange, ticker, recovery);
+        recovery.buffered.push_back(msg);
+        return;
+    }
+    if (first < recovery.next_sequence)
+    {
+        // Only market by order updates span several sequence numbers, so drop the events already in the snapshot
+        MarketByOrderMessagePtr update = std::static_pointer_cast<MarketByOrderMessage>(msg);
+        std::vector<OrderEvent> events = update->getEvents();
+        MarketByOrderMessagePtr remainder = std::make_shared<MarketByOrderMessage>(*update);
+        remainder->sequence = recovery.next_sequence;
+        remainder->setEvents(events.begin() + (recovery.next_sequence - first), events.end());
+        msg = remainder;
+    }
+    ready.push_back(msg);
+    recovery.next_sequence = last + 1;
+}
+
+void TraderAgent::deliverUpdate(std::string_view exchange, MessagePtr msg)
+{
+    if (msg->type == MessageType::MARKET_DEPTH)
+    {
+        onMarketDepth(exchange, std::static_pointer_cast<MarketDepthMessage>(msg));
+    }
+    else
+    {
+        onMarketByOrder(exchange, std::static_pointer_cast<MarketByOrderMessage>(msg));
+    }
+}
+
+std::pair<unsigned long long, unsigned long long> TraderAgent::sequenceRange(MessagePtr msg)
+{
+    if (msg->type == MessageType::MARKET_DEPTH)
+    {
+        unsigned long long sequence = std::static_pointer_cast<MarketDepthMessage>(msg)->sequence;
+        return {sequence, sequence};
+    }
+    MarketByOrderMessagePtr update = std::static_pointer_cast<MarketByOrderMessage>(msg);
+    return {update->sequence, update->sequence + update->count - 1};
 }
\ No newline at end of file
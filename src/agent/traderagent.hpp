@@ -2,11 +2,17 @@
 #define TRADER_AGENT_HPP
 
 #include <iostream>
+#include <map>
+#include <deque>
+#include <vector>
+#include <mutex>
 
 #include "agent.hpp"
 #include "../config/traderconfig.hpp"
 #include "../order/order.hpp"
 #include "../message/market_data_message.hpp"
+#include "../message/market_depth_message.hpp"
+#include "../message/market_by_order_message.hpp"
 #include "../message/exec_report_message.hpp"
 #include "../message/subscribe_message.hpp"
 #include "../message/limit_order_message.hpp"
@@ -14,6 +20,9 @@
 #include "../message/cancel_order_message.hpp"
 #include "../message/event_message.hpp"
 #include "../message/cancel_reject_message.hpp"
+#include "../message/snapshot_request_message.hpp"
+#include "../message/snapshot_message.hpp"
+#include "../message/multicast_group_message.hpp"
 
 class TraderAgent : public Agent
 {
@@ -30,8 +39,14 @@ public:
     /** Gracefully terminates the trader, freeing all memory. */
     virtual void terminate() override;
 
-    /** Subscribes to updates for the stock with the given ticker at the given exchange. */
-    void subscribeToMarket(std::string_view exchange, std::string_view ticker);
+    /** Subscribes to updates for the stock with the given ticker at the given exchange.
+     *  Level 2 subscriptions receive the given number of levels on each side, or the full book for 0.
+     *  Level 2 and market by order updates are delivered in sequence after a snapshot of the book,
+     *  which is requested again whenever an update is lost. */
+    void subscribeToMarket(std::string_view exchange, std::string_view ticker, SubscribeMessage::Feed feed = SubscribeMessage::Feed::LEVEL_1, int depth = 0);
+
+    /** Asks the given exchange for a snapshot of the given ticker's book as seen by the given feed. */
+    void requestSnapshot(std::string_view exchange, std::string_view ticker, SubscribeMessage::Feed feed, int depth = 0);
 
     /** Places a limit order for the given ticker at the given exchange. */
     void placeLimitOrder(std::string_view exchange, Order::Side side, std::string_view ticker, int quantity, double price, double priv_value,
@@ -59,6 +74,15 @@ protected:
     /** The callback function called when new market data update is received. */
     virtual void onMarketData(std::string_view exchange, MarketDataMessagePtr msg) = 0;
 
+    /** The callback function called when a level 2 depth update is received, ignored by default. */
+    virtual void onMarketDepth(std::string_view exchange, MarketDepthMessagePtr msg) {};
+
+    /** The callback function called when a market by order update is received, ignored by default. */
+    virtual void onMarketByOrder(std::string_view exchange, MarketByOrderMessagePtr msg) {};
+
+    /** The callback function called when a snapshot of a book is received, before any updates following it. Ignored by default. */
+    virtual void onSnapshot(std::string_view exchange, SnapshotMessagePtr msg) {};
+
     /** The callback function called when the execution report message is received. */
     virtual void onExecutionReport(std::string_view exchange, ExecutionReportMessagePtr msg) = 0;
 
@@ -76,6 +100,45 @@ private:
     /** Signals that trading has started and starts sending callbacks to handlers. */
     void signalTradingStart();
 
+    /** Most updates held back while waiting for a snapshot, older ones are dropped beyond this. */
+    static constexpr size_t MAX_BUFFERED_UPDATES = 4096;
+
+    /** Sequencing state of a level 2 or market by order subscription. */
+    struct FeedRecovery
+    {
+        SubscribeMessage::Feed feed;
+        int depth;
+        bool synchronised = false;
+        bool snapshot_requested = false;
+        unsigned long long next_sequence = 0;
+        std::deque<MessagePtr> buffered;
+    };
+
+    /** Stops delivering updates of the given subscription and requests a snapshot to resume from. */
+    void resynchronise(std::string_view exchange, std::string_view ticker, FeedRecovery& recovery);
+
+    /** Handles a received snapshot, returning the buffered updates following it. */
+    std::vector<MessagePtr> onSnapshotReceived(std::string_view exchange, SnapshotMessagePtr msg);
+
+    /** Returns true if the given subscription is to level 2 or market by order updates. */
+    bool isSequenced(std::string_view exchange, std::string_view ticker);
+
+    /** Returns true if the given update belongs to the feed and depth of the given subscription. */
+    static bool isPartOf(FeedRecovery const& recovery, MessagePtr msg);
+
+    /** Sequences a received update, returning the updates ready to be delivered. Updates of
+     *  other feeds, as received on a multicast group carrying all of them, are dropped. */
+    std::vector<MessagePtr> sequenceUpdate(std::string_view exchange, std::string_view ticker, MessagePtr msg);
+
+    /** Appends the given update to the updates to deliver if it follows the last one, or buffers it until the next snapshot. */
+    void applyUpdate(std::string_view exchange, std::string_view ticker, FeedRecovery& recovery, MessagePtr msg, std::vector<MessagePtr>& ready);
+
+    /** Makes the level 2 or market by order callback for the given update. */
+    void deliverUpdate(std::string_view exchange, MessagePtr msg);
+
+    /** Returns the first and last sequence numbers covered by the given update. */
+    static std::pair<unsigned long long, unsigned long long> sequenceRange(MessagePtr msg);
+
     /** TODO: Signals that trading has ended and stops sending callbacks to handlers. */
     // void signalTradingEnd();
 
@@ -84,6 +147,10 @@ private:
     unsigned int start_delay_in_seconds_ = 0;
     std::mutex mutex_;
     std::thread* delay_thread_;
+
+    /** Recovery state of each sequenced subscription, by exchange and ticker. */
+    std::map<std::pair<std::string, std::string>, FeedRecovery> feed_recovery_;
+    std::mutex feed_mutex_;
 };
 
 #endif
\ No newline at end of file
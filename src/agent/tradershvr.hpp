@@ -25,14 +25,14 @@ public:
 
     void onTradingStart() override
     {
-        std::cout << "Trading window started.\n";
+        LOG_INFO << "Trading window started.";
         is_trading_ = true;
     }
 
     void onTradingEnd() override
     {
         is_trading_ = false;
-        std::cout << "Trading window ended.\n";
+        LOG_INFO << "Trading window ended.";
     }
 
     void onMarketData(std::string_view exchange, MarketDataMessagePtr msg) override
@@ -42,14 +42,14 @@ public:
         {
             double price = getShaverPrice(msg);
             placeLimitOrder(exchange_, trader_side_, ticker_, quantity, price, limit_price_);
-            std::cout << ">> " << (trader_side_ == Order::Side::BID ? "BID" : "ASK") << " " << quantity << " @ " << price << "\n";
+            LOG_DEBUG << ">> " << (trader_side_ == Order::Side::BID ? "BID" : "ASK") << " " << quantity << " @ " << price;
         }
     }
 
     void onExecutionReport(std::string_view exchange, ExecutionReportMessagePtr msg) override
     {
-        std::cout << "Received execution report from " << exchange << ": Order: " << msg->order->id << " Status: " << msg->order->status << 
-        " Qty remaining = " << msg->order->remaining_quantity << "\n";
+        LOG_DEBUG << "Received execution report from " << exchange << ": Order: " << msg->order->id << " Status: " << msg->order->status << 
+        " Qty remaining = " << msg->order->remaining_quantity;
     }
 
     void onCancelReject(std::string_view exchange, CancelRejectMessagePtr msg) override
@@ -63,12 +63,12 @@ private:
     {
         if (trader_side_ == Order::Side::BID)
         {
-            double shaved_price = msg->data->best_bid + 1;
+            double shaved_price = msg->data->best_bid.toDouble() + 1;
             return std::min(shaved_price, limit_price_);
         }
         else
         {
-            double shaved_price = msg->data->best_ask - 1;
+            double shaved_price = msg->data->best_ask.toDouble() - 1;
             return std::max(shaved_price, limit_price_);
         }
     }
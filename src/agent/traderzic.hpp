@@ -43,7 +43,7 @@ public:
 
     void onTradingStart() override
     {
-        std::cout << "Trading window started.\n";
+        LOG_INFO << "Trading window started.";
         is_trading_ = true;
         activelyTrade();
     }
@@ -51,14 +51,14 @@ public:
     void onTradingEnd() override
     {
         std::unique_lock<std::mutex> lock(mutex_);
-        std::cout << "Trading window ended.\n";
+        LOG_INFO << "Trading window ended.";
         is_trading_ = false;
         lock.unlock();
     }
 
     void onMarketData(std::string_view exchange, MarketDataMessagePtr msg) override
     {
-        std::cout << "Received market data from " << exchange << "\n";
+        LOG_DEBUG << "Received market data from " << exchange;
     }
 
     void onExecutionReport(std::string_view exchange, ExecutionReportMessagePtr msg) override
@@ -75,7 +75,7 @@ public:
 
     void onCancelReject(std::string_view exchange, CancelRejectMessagePtr msg) override
     {
-        std::cout << "Received cancel reject from " << exchange << ": Order: " << msg->order_id;
+        LOG_DEBUG << "Received cancel reject from " << exchange << ": Order: " << msg->order_id;
     }
 
 private:
@@ -96,7 +96,7 @@ private:
             }
             lock.unlock();
 
-            std::cout << "Finished actively trading.\n";
+            LOG_INFO << "Finished actively trading.";
         });
     }
 
@@ -123,8 +123,8 @@ private:
         double price = getRandomPrice();
         placeLimitOrder(exchange_, trader_side_, ticker_, quantity, price, limit_price_);
 
-        std::cout << ">> " << (trader_side_ == Order::Side::BID ? "BID" : "ASK") 
-        << " " << quantity << " @ " << price << "\n";
+        LOG_DEBUG << ">> " << (trader_side_ == Order::Side::BID ? "BID" : "ASK") 
+        << " " << quantity << " @ " << price;
     }
 
     double getRandomPrice()
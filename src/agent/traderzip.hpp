@@ -48,7 +48,7 @@ public:
 
     void onTradingStart() override
     {
-        std::cout << "Trading window started.\n";
+        LOG_INFO << "Trading window started.";
         next_undercut_timestamp_ = timeNow() + (liquidity_interval_ms_ * MS_TO_NS);
         next_lower_margin_timestamp_ = timeNow() + (trade_interval_ms_ * MS_TO_NS);
         is_trading_ = true;
@@ -58,7 +58,7 @@ public:
     void onTradingEnd() override
     {
         std::unique_lock<std::mutex> lock(mutex_);
-        std::cout << "Trading window ended.\n";
+        LOG_INFO << "Trading window ended.";
         is_trading_ = false;
         lock.unlock();
     }
@@ -109,9 +109,9 @@ private:
         last_accepted_order_id_ = std::nullopt;
         last_market_data_ = std::nullopt;
 
-        std::cout << "mom=" << momentum_ << "\n";
-        std::cout << "lr=" << learning_rate_ << "\n";
-        std::cout << "margin=" << profit_margin_ << "\n";
+        LOG_DEBUG << "mom=" << momentum_;
+        LOG_DEBUG << "lr=" << learning_rate_;
+        LOG_DEBUG << "margin=" << profit_margin_;
     }
 
     void activelyTrade()
@@ -138,7 +138,7 @@ private:
             }
             lock.unlock();
 
-            std::cout << "Finished actively trading.\n";
+            LOG_INFO << "Finished actively trading.";
         });
     }
 
@@ -154,9 +154,9 @@ private:
             if (msg->data->last_price_traded > last_market_data_.value()->last_price_traded)
             {
                 // Raise margin for sellers
-                if (trader_side_ == Order::Side::ASK && last_price_ <= msg->data->last_price_traded)
+                if (trader_side_ == Order::Side::ASK && last_price_ <= msg->data->last_price_traded.toDouble())
                 {
-                    double target = increaseTargetPrice(msg->data->last_price_traded);
+                    double target = increaseTargetPrice(msg->data->last_price_traded.toDouble());
                     updateMargin(target);
                 }
             }
@@ -164,9 +164,9 @@ private:
             else if (msg->data->last_price_traded < last_market_data_.value()->last_price_traded)
             {
                 // Raise margin for buyers
-                if (trader_side_ == Order::Side::BID && last_price_ >= msg->data->last_price_traded)
+                if (trader_side_ == Order::Side::BID && last_price_ >= msg->data->last_price_traded.toDouble())
                 {
-                    double target = decreaseTargetPrice(msg->data->last_price_traded);
+                    double target = decreaseTargetPrice(msg->data->last_price_traded.toDouble());
                     updateMargin(target);
                 }
             }
@@ -174,14 +174,14 @@ private:
             // Lower margin for buyers (conditional)
             if (trader_side_ == Order::Side::BID && timeNow() > next_lower_margin_timestamp_)
             {
-                double target = increaseTargetPrice(msg->data->last_price_traded);
+                double target = increaseTargetPrice(msg->data->last_price_traded.toDouble());
                 updateMargin(target);
                 next_lower_margin_timestamp_ = timeNow() + (trade_interval_ms_ * MS_TO_NS);
             }
             // Lower margin for sellers (conditional)
             else if (trader_side_ == Order::Side::ASK && timeNow() > next_lower_margin_timestamp_)
             {
-                double target = decreaseTargetPrice(msg->data->last_price_traded);
+                double target = decreaseTargetPrice(msg->data->last_price_traded.toDouble());
                 updateMargin(target);
                 next_lower_margin_timestamp_ = timeNow() + (trade_interval_ms_ * MS_TO_NS);
             }
@@ -218,7 +218,7 @@ private:
         {
             if (last_market_data_.value()->best_ask_size > 0)
             {
-                double best_ask = last_market_data_.value()->best_ask;
+                double best_ask = last_market_data_.value()->best_ask.toDouble();
                 double target = increaseTargetPrice(best_ask);
                 updateMargin(target);
 
@@ -230,7 +230,7 @@ private:
         {
             if (last_market_data_.value()->best_bid_size > 0)
             {
-                double best_bid = last_market_data_.value()->best_bid;
+                double best_bid = last_market_data_.value()->best_bid.toDouble();
                 double target = decreaseTargetPrice(best_bid);
                 updateMargin(target);
 
@@ -271,7 +271,7 @@ private:
             profit_margin_ = std::max(min_margin_, new_margin);
         }
 
-        std::cout << "[Margin Update] Target = " << target_price << " Margin = " << new_margin << " Actual = " << profit_margin_ << "\n";
+        LOG_DEBUG << "[Margin Update] Target = " << target_price << " Margin = " << new_margin << " Actual = " << profit_margin_;
     }
 
     double increaseTargetPrice(double price)
@@ -302,7 +302,7 @@ private:
         // Place new order with a new price
         last_price_ = getQuotePrice();
         placeLimitOrder(exchange_, trader_side_, ticker_, 100, last_price_, limit_price_, Order::TimeInForce::GTC, ++last_client_order_id_);
-        std::cout << ">> " << (trader_side_ == Order::Side::BID ? "BID" : "ASK") << " " << 100 << " @ " << last_price_ << "\n";
+        LOG_DEBUG << ">> " << (trader_side_ == Order::Side::BID ? "BID" : "ASK") << " " << 100 << " @ " << last_price_;
     }
 
 
@@ -0,0 +1,91 @@
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <string>
+#include <iostream>
+
+#include "../utilities/ringqueue.hpp"
+#include "../utilities/syncqueue.hpp"
+
+/** Microbenchmark of the shard inbound queue: producers push shared pointers, as the network
+ *  threads do with decoded messages, while a single consumer pops them as the matching engine does.
+ *  Usage: ringqueue_bench [messages] [producers] */
+
+struct Payload
+{
+    int value;
+};
+
+typedef std::shared_ptr<Payload> PayloadPtr;
+
+/** Pushes the given number of messages from each producer through the queue and returns the elapsed seconds. */
+template <typename Queue>
+double run(Queue& queue, size_t messages, int producers)
+{
+    size_t per_producer = messages / producers;
+    size_t total = per_producer * producers;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p)
+    {
+        threads.emplace_back([&queue, per_producer]{
+            for (size_t i = 0; i < per_producer; ++i)
+            {
+                queue.push(std::make_shared<Payload>(Payload{static_cast<int>(i)}));
+            }
+        });
+    }
+
+    size_t received = 0;
+    long long checksum = 0;
+    while (received < total)
+    {
+        PayloadPtr payload = queue.pop();
+        checksum += payload->value;
+        ++received;
+    }
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    // Keep the consumer's reads from being optimised away
+    if (checksum < 0) std::cout << checksum;
+    return elapsed.count();
+}
+
+void report(std::string_view name, int producers, size_t messages, double seconds)
+{
+    std::cout << name << " " << producers << " producer(s): " << seconds << "s, "
+              << static_cast<size_t>(messages / seconds) << " msg/s\n";
+}
+
+int main(int argc, char* argv[])
+{
+    size_t messages = argc > 1 ? std::stoul(argv[1]) : 500000;
+    int max_producers = argc > 2 ? std::stoi(argv[2]) : 4;
+
+    for (int producers : {1, max_producers})
+    {
+        {
+            SyncQueue<PayloadPtr> queue;
+            report("SyncQueue", producers, messages, run(queue, messages, producers));
+        }
+        {
+            RingQueue<PayloadPtr> queue;
+            report("RingQueue", producers, messages, run(queue, messages, producers));
+        }
+        if (producers == 1)
+        {
+            SPSCRingQueue<PayloadPtr> queue;
+            report("SPSCRingQueue", producers, messages, run(queue, messages, producers));
+        }
+        if (max_producers == 1) break;
+    }
+    return 0;
+}
@@ -8,6 +8,7 @@
 #include <boost/serialization/vector.hpp>
 
 #include "../agent/agenttype.hpp"
+#include "../networking/wireformat.hpp"
 
 /** Used to configure an instance of an agent in the simulation. */
 class AgentConfig : std::enable_shared_from_this<AgentConfig>
@@ -20,6 +21,7 @@ public:
     int agent_id;
     std::string addr;
     AgentType type;
+    WireFormat wire_format = WireFormat::BINARY;
 
 private:
 
@@ -30,6 +32,7 @@ private:
         ar & agent_id;
         ar & addr;
         ar & type;
+        ar & wire_format;
     }
 };
 
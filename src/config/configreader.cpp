@@ -1,5 +1,7 @@
 #include "configreader.hpp"
 #include "../agent/agentfactory.hpp"
+#include "../utilities/logger.hpp"
+#include "../order/tickladderqueue.hpp"
 
 SimulationConfigPtr ConfigReader::readConfig(std::string& filepath)
 {
@@ -51,6 +53,7 @@ SimulationConfigPtr ConfigReader::readConfig(std::string& filepath)
     for (auto exchange : exchanges.children())
     {
         ExchangeConfigPtr exchange_config = configureExchange(agent_id, exchange, exchange_addrs.at(instance_id));
+        configureWireFormat(exchange_config, exchange);
         exchange_addrs_map.insert({exchange_config->name, exchange_addrs.at(instance_id)});
         exchange_configs.push_back(exchange_config);
         ++instance_id;
@@ -65,6 +68,7 @@ SimulationConfigPtr ConfigReader::readConfig(std::string& filepath)
     for (auto trader : traders.children())
     {
         AgentConfigPtr agent_config = configureAgent(agent_id, trader, trader_addrs.at(instance_id), exchange_addrs_map);
+        configureWireFormat(agent_config, trader);
          
         trader_configs.push_back(agent_config);
         ++instance_id;
@@ -120,13 +124,101 @@ ExchangeConfigPtr ConfigReader::configureExchange(int id, pugi::xml_node& xml_no
 
     exchange_config->addr = addr;
     exchange_config->name = std::string{xml_node.attribute("name").value()};
-    exchange_config->tickers = std::vector{std::string{xml_node.attribute("ticker").value()}};
     exchange_config->connect_time = std::atoi(xml_node.attribute("connect-time").value());
     exchange_config->trading_time = std::atoi(xml_node.attribute("trading-time").value());
+    exchange_config->huge_pages = xml_node.attribute("huge-pages").as_bool(false);
+    exchange_config->sharded = xml_node.attribute("sharded").as_bool(false);
+
+    std::string tape_format {xml_node.attribute("tape-format").value()};
+    if (tape_format == "binary")
+    {
+        exchange_config->tape_format = TapeFormat::BINARY;
+    }
+    else if (!tape_format.empty() && tape_format != "csv")
+    {
+        throw std::runtime_error("Unknown tape format " + tape_format + " for exchange " + exchange_config->name);
+    }
+    exchange_config->tape_buffer_size = xml_node.attribute("tape-buffer-size").as_ullong(exchange_config->tape_buffer_size);
+    exchange_config->tape_flush_interval = xml_node.attribute("tape-flush-interval").as_int(exchange_config->tape_flush_interval);
+    if (exchange_config->tape_flush_interval <= 0)
+    {
+        throw std::runtime_error("Tape flush interval for exchange " + exchange_config->name + " must be positive");
+    }
+
+    // A single ticker may be declared on the exchange itself, further tickers as child elements
+    if (!xml_node.attribute("ticker").empty())
+    {
+        std::string ticker {xml_node.attribute("ticker").value()};
+        exchange_config->tickers.push_back(ticker);
+        exchange_config->ticker_configs.insert({ticker, configureTicker(ticker, xml_node)});
+    }
+
+    for (auto ticker_node : xml_node.children("ticker"))
+    {
+        std::string ticker {ticker_node.attribute("name").value()};
+        exchange_config->tickers.push_back(ticker);
+        exchange_config->ticker_configs.insert({ticker, configureTicker(ticker, ticker_node)});
+    }
 
     return exchange_config;
 }
 
+void ConfigReader::configureWireFormat(AgentConfigPtr config, pugi::xml_node& xml_node)
+{
+    if (!xml_node.attribute("wire-format").empty())
+    {
+        config->wire_format = parseWireFormat(xml_node.attribute("wire-format").value());
+    }
+}
+
+TickerConfig ConfigReader::configureTicker(std::string_view ticker, pugi::xml_node& xml_node)
+{
+    TickerConfig ticker_config {ticker};
+
+    std::string book_type {xml_node.attribute("order-book").value()};
+    if (book_type == "ladder")
+    {
+        ticker_config.book_type = TickerConfig::BookType::TICK_LADDER;
+    }
+    else if (!book_type.empty() && book_type != "levels")
+    {
+        throw std::runtime_error("Unknown order book type " + book_type + " for ticker " + std::string{ticker});
+    }
+
+    if (!xml_node.attribute("tick-size").empty())
+    {
+        ticker_config.tick_size = Price::fromDouble(xml_node.attribute("tick-size").as_double());
+    }
+    if (ticker_config.tick_size <= Price{})
+    {
+        throw std::runtime_error("Tick size for ticker " + std::string{ticker} + " must be positive");
+    }
+    ticker_config.min_price = Price::fromDouble(xml_node.attribute("min-price").as_double(0));
+    ticker_config.max_price = Price::fromDouble(xml_node.attribute("max-price").as_double(0));
+    ticker_config.shard = xml_node.attribute("shard").as_int(-1);
+    ticker_config.min_publish_interval = xml_node.attribute("min-publish-interval").as_int(0);
+    if (ticker_config.min_publish_interval < 0)
+    {
+        throw std::runtime_error("Minimum publish interval for ticker " + std::string{ticker} + " must not be negative");
+    }
+    ticker_config.multicast_group = std::string{xml_node.attribute("multicast-group").value()};
+
+    // The tick ladder can only be used once the price band is declared
+    if (ticker_config.book_type == TickerConfig::BookType::TICK_LADDER
+        && ticker_config.max_price <= ticker_config.min_price)
+    {
+        throw std::runtime_error("Ladder order book for ticker " + std::string{ticker} + " requires min-price and max-price");
+    }
+    if (ticker_config.book_type == TickerConfig::BookType::TICK_LADDER
+        && (ticker_config.max_price - ticker_config.min_price).ticks(ticker_config.tick_size) >= TickLadderQueue::MAX_LEVELS)
+    {
+        throw std::runtime_error("Ladder order book for ticker " + std::string{ticker} + " spans more than "
+            + std::to_string(TickLadderQueue::MAX_LEVELS) + " ticks, use a larger tick-size or a narrower price band");
+    }
+
+    return ticker_config;
+}
+
 AgentConfigPtr ConfigReader::configureTrader(int id, pugi::xml_node& xml_node, std::string& addr, std::unordered_map<std::string, std::string>& exchange_addrs, AgentType trader_type)
 {
     TraderConfigPtr trader_config = std::make_shared<TraderConfig>();
@@ -215,9 +307,9 @@ AgentConfigPtr ConfigReader::configureTraderZIP(int id, pugi::xml_node& xml_node
     else if (side == "sell") config->side = Order::Side::ASK;
 
     config->min_margin = std::stod(xml_node.attribute("min-margin").value());
-    std::cout << "trade: " << xml_node.attribute("trade-interval").value() << "\n";
+    LOG_DEBUG << "trade: " << xml_node.attribute("trade-interval").value();
     config->trade_interval = std::stoul(xml_node.attribute("trade-interval").value());
-    std::cout << "liquidity: " << xml_node.attribute("liquidity-interval").value() << "\n";
+    LOG_DEBUG << "liquidity: " << xml_node.attribute("liquidity-interval").value();
     config->liquidity_interval = std::stoul(xml_node.attribute("liquidity-interval").value());
 
 
@@ -26,6 +26,10 @@ private:
 
     static ExchangeConfigPtr configureExchange(int id, pugi::xml_node& xml_node, std::string& addr);
 
+    static void configureWireFormat(AgentConfigPtr config, pugi::xml_node& xml_node);
+
+    static TickerConfig configureTicker(std::string_view ticker, pugi::xml_node& xml_node);
+
     static AgentConfigPtr configureTrader(int id, pugi::xml_node& xml_node, std::string& addr, std::unordered_map<std::string, std::string>& exchange_addr, AgentType trader_type);
 
     static AgentConfigPtr configureArbitrageur(int id, pugi::xml_node& xml_node, std::string& addr, std::unordered_map<std::string, std::string>& exchange_addr);
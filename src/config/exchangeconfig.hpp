@@ -2,6 +2,8 @@
 #define EXCHANGE_CONFIG_HPP
 
 #include "agentconfig.hpp"
+#include "tickerconfig.hpp"
+#include "../tape/tapeformat.hpp"
 
 class ExchangeConfig : public AgentConfig
 {
@@ -11,8 +13,14 @@ public:
 
     std::string name;
     std::vector<std::string> tickers;
+    std::unordered_map<std::string, TickerConfig> ticker_configs;
     int connect_time;
     int trading_time;
+    bool huge_pages = false;
+    bool sharded = false;
+    TapeFormat tape_format = TapeFormat::CSV;
+    size_t tape_buffer_size = 1 << 20;          // Bytes of formatted rows buffered by each tape before a write
+    int tape_flush_interval = 100;              // Longest milliseconds a row stays buffered before it is written
 
 private:
 
@@ -23,8 +31,14 @@ private:
         ar & boost::serialization::base_object<AgentConfig>(*this);
         ar & name;
         ar & tickers;
+        ar & ticker_configs;
         ar & connect_time;
         ar & trading_time;
+        ar & huge_pages;
+        ar & sharded;
+        ar & tape_format;
+        ar & tape_buffer_size;
+        ar & tape_flush_interval;
     }
 };
 
@@ -0,0 +1,55 @@
+#ifndef TICKER_CONFIG_HPP
+#define TICKER_CONFIG_HPP
+
+#include <string>
+
+#include <boost/archive/text_oarchive.hpp>
+#include <boost/archive/text_iarchive.hpp>
+#include <boost/serialization/string.hpp>
+
+#include "../order/price.hpp"
+
+/** Used to configure the order book of a single ticker traded on an exchange. */
+class TickerConfig
+{
+public:
+
+    enum class BookType : int {
+        PRICE_LEVEL,                 // Sorted price levels, any price
+        TICK_LADDER                  // Array of levels indexed by tick, bounded price band
+    };
+
+    TickerConfig() = default;
+
+    TickerConfig(std::string_view ticker)
+    : ticker{std::string(ticker)}
+    {
+    }
+
+    std::string ticker;
+    BookType book_type = BookType::PRICE_LEVEL;
+    Price tick_size = Price::fromUnits(Price::SCALE / 100);
+    Price min_price;
+    Price max_price;
+    int shard = -1;                  // Tickers with the same shard share a matching thread, -1 for a dedicated one
+    int min_publish_interval = 0;    // Minimum milliseconds between market data snapshots, 0 to publish on every change
+    std::string multicast_group;     // Address and port market data is published to once, empty to send it to each subscriber
+
+private:
+
+    friend class boost::serialization::access;
+    template<class Archive>
+    void serialize(Archive & ar, const unsigned int version)
+    {
+        ar & ticker;
+        ar & book_type;
+        ar & tick_size;
+        ar & min_price;
+        ar & max_price;
+        ar & shard;
+        ar & min_publish_interval;
+        ar & multicast_group;
+    }
+};
+
+#endif
@@ -1,6 +1,7 @@
 #include <iostream>
 #include <chrono>
 #include <thread>
+#include <fstream>
 
 #include <boost/asio.hpp>
 #include <boost/archive/text_oarchive.hpp>
@@ -25,6 +26,10 @@
 #include "config/exchangeconfig.hpp"
 #include "config/traderconfig.hpp"
 
+#include "tape/tapereader.hpp"
+
+#include "utilities/logger.hpp"
+
 namespace asio = boost::asio;
 namespace po = boost::program_options;
 
@@ -36,6 +41,7 @@ std::string showUsage()
     ss << "  " << "local" << "\t\t" << "run simulation in local mode" << "\n";
     ss << "  " << "orchestrator" << "\t" << "orchestrate the cloud simulation from this node" << "\n";
     ss << "  " << "node" << "\t\t" << "run as a simulation node" << "\n";
+    ss << "  " << "convert" << "\t" << "convert a binary tape to CSV" << "\n";
     return ss.str();
 }
 
@@ -61,10 +67,19 @@ void local_runner(int argc, char** argv)
         ("exchange-name", po::value<std::string>()->default_value(std::string{"LSE"}), "set the name of the exchange")
         ("connect-time", po::value<int>()->default_value(30), "(exchange only) the time allowed for traders to connect (seconds)")
         ("trading-time", po::value<int>()->default_value(60), "(exchange only) the time of the trading window (seconds)")
+        ("huge-pages", po::bool_switch(), "(exchange only) back the matching engine object pools with huge pages")
+        ("tape-format", po::value<std::string>()->default_value(std::string{"csv"}), "(exchange only) set the format of the tapes written: csv or binary")
+        ("tape-buffer-size", po::value<size_t>()->default_value(1 << 20), "(exchange only) set the bytes of rows each tape buffers before writing them")
+        ("tape-flush-interval", po::value<int>()->default_value(100), "(exchange only) set the longest time a row stays buffered before it is written (milliseconds)")
+        ("multicast-group", po::value<std::string>()->default_value(std::string{}), "(exchange only) publish market data once to the given multicast address and port")
         ("delay", po::value<unsigned int>()->default_value(0), "(trader only) delayed start for trader (seconds)")
         ("side", po::value<std::string>()->default_value(std::string{"buyer"}), "(trader only) set the trader side: buyer or seller")
         ("limit", po::value<double>()->default_value(100), "(trader only) set the limit price of the trader")
         ("exchange-addr", po::value<std::string>()->default_value(std::string{"127.0.0.1:9999"}), "(trader only) set the IPv4 address of the exchange")
+        ("log-level", po::value<std::string>()->default_value(std::string{"info"}), "set the lowest level of diagnostics logged: trace, debug, info, warn, error or off")
+        ("wire-format", po::value<std::string>()->default_value(std::string{"binary"}), "set the format messages are sent in: binary, or text for debugging")
+        ("io-threads", po::value<size_t>()->default_value(1), "set the number of threads serving network connections")
+        ("decode-threads", po::value<size_t>()->default_value(0), "set the number of threads decoding incoming messages, or 0 to decode them on the network threads")
     ;
 
     po::variables_map vm;
@@ -76,6 +91,7 @@ void local_runner(int argc, char** argv)
         std::cout << "\n" << showLocalUsage() << desc << std::endl;
         exit(1);
     }
+    Logger::setLevel(parseLogLevel(vm["log-level"].as<std::string>()));
 
     std::string agent_type { argv[2] };
     int agent_id { std::stoi(argv[3]) };
@@ -83,6 +99,9 @@ void local_runner(int argc, char** argv)
 
     asio::io_context io_context;
     NetworkEntity entity{io_context, std::string{"127.0.0.1"}, port};
+    entity.setWireFormat(parseWireFormat(vm["wire-format"].as<std::string>()));
+    entity.setIoThreads(vm["io-threads"].as<size_t>());
+    entity.setDecodeThreads(vm["decode-threads"].as<size_t>());
 
     if (agent_type == "exchange")
     {
@@ -93,6 +112,14 @@ void local_runner(int argc, char** argv)
         config->tickers = std::vector { vm["ticker"].as<std::string>() };
         config->connect_time = vm["connect-time"].as<int>();
         config->trading_time = vm["trading-time"].as<int>();
+        config->huge_pages = vm["huge-pages"].as<bool>();
+        config->tape_format = (vm["tape-format"].as<std::string>() == "binary") ? TapeFormat::BINARY : TapeFormat::CSV;
+        config->tape_buffer_size = vm["tape-buffer-size"].as<size_t>();
+        config->tape_flush_interval = vm["tape-flush-interval"].as<int>();
+
+        TickerConfig ticker_config {vm["ticker"].as<std::string>()};
+        ticker_config.multicast_group = vm["multicast-group"].as<std::string>();
+        config->ticker_configs.insert({ticker_config.ticker, ticker_config});
 
         std::shared_ptr<StockExchange> exchange (new StockExchange{&entity, config});
         entity.setAgent(std::static_pointer_cast<Agent>(exchange));
@@ -156,6 +183,9 @@ void node_runner(int argc, char** argv)
     desc.add_options()
         ("help", "show help message")
         ("port", po::value<unsigned short>()->default_value(8080), "set the port of the current agent")
+        ("log-level", po::value<std::string>()->default_value(std::string{"info"}), "set the lowest level of diagnostics logged: trace, debug, info, warn, error or off")
+        ("io-threads", po::value<size_t>()->default_value(1), "set the number of threads serving network connections")
+        ("decode-threads", po::value<size_t>()->default_value(0), "set the number of threads decoding incoming messages, or 0 to decode them on the network threads")
     ;
 
     po::variables_map vm;
@@ -167,11 +197,14 @@ void node_runner(int argc, char** argv)
         std::cout << "\n" << desc << std::endl;
         exit(1);
     }
+    Logger::setLevel(parseLogLevel(vm["log-level"].as<std::string>()));
 
     unsigned short port { vm["port"].as<unsigned short>() };
 
     asio::io_context io_context;
     NetworkEntity entity{io_context, port};
+    entity.setIoThreads(vm["io-threads"].as<size_t>());
+    entity.setDecodeThreads(vm["decode-threads"].as<size_t>());
     entity.start();
 }
 
@@ -182,6 +215,7 @@ void orchestrator(int argc, char** argv)
         ("help", "show help message")
         ("port", po::value<unsigned short>()->default_value(8080), "set the port of the orchestrator agent")
         ("config", po::value<std::string>()->default_value(std::string{"simulation.xml"}, "set the path to the configuration file"))
+        ("log-level", po::value<std::string>()->default_value(std::string{"info"}), "set the lowest level of diagnostics logged: trace, debug, info, warn, error or off")
     ;
 
     po::variables_map vm;
@@ -193,6 +227,7 @@ void orchestrator(int argc, char** argv)
         std::cout << "\n" << desc << std::endl;
         exit(1);
     }
+    Logger::setLevel(parseLogLevel(vm["log-level"].as<std::string>()));
 
     unsigned short port { vm["port"].as<unsigned short>() };
     std::string filepath { vm["config"].as<std::string>() };
@@ -215,6 +250,40 @@ void orchestrator(int argc, char** argv)
     entity.start();
 }
 
+void converter(int argc, char** argv)
+{
+    po::options_description desc("Allowed options");
+    desc.add_options()
+        ("help", "show help message")
+        ("input", po::value<std::string>(), "set the path to the binary tape")
+        ("output", po::value<std::string>(), "set the path to the CSV file, standard output if not given")
+    ;
+
+    po::positional_options_description positional;
+    positional.add("input", 1).add("output", 1);
+
+    po::variables_map vm;
+    po::store(po::command_line_parser(argc - 1, argv + 1).options(desc).positional(positional).run(), vm);
+    po::notify(vm);
+
+    if (vm.count("help") || !vm.count("input"))
+    {
+        std::cout << "\n" << "Usage: ./simulation convert <tape> [<csv>]" << "\n\n" << desc << std::endl;
+        exit(1);
+    }
+
+    TapeReader reader {vm["input"].as<std::string>()};
+    if (vm.count("output"))
+    {
+        std::ofstream file {vm["output"].as<std::string>()};
+        reader.writeCSV(file);
+    }
+    else
+    {
+        reader.writeCSV(std::cout);
+    }
+}
+
 int main(int argc, char** argv)
 {
 
@@ -233,6 +302,10 @@ int main(int argc, char** argv)
     {
         orchestrator(argc, argv);
     }
+    else if (mode == "convert")
+    {
+        converter(argc, argv);
+    }
     else
     {
         node_runner(argc, argv);
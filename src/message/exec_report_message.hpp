@@ -5,6 +5,7 @@
 #include "messagetype.hpp"
 #include "../order/order.hpp"
 #include "../trade/trade.hpp"
+#include "../utilities/memorypool.hpp"
 
 class ExecutionReportMessage : public Message
 {
@@ -13,23 +14,24 @@ public:
     ExecutionReportMessage() : Message(MessageType::EXECUTION_REPORT) {};
 
     /** Creates an ExecutionReport message from a new or cancelled order. */
-    static std::shared_ptr<ExecutionReportMessage> createFromOrder(OrderPtr order)
+    static std::shared_ptr<ExecutionReportMessage> createFromOrder(OrderPtr order, ObjectPool<ExecutionReportMessage>* pool = nullptr)
     {
-        std::shared_ptr<ExecutionReportMessage> message = std::make_shared<ExecutionReportMessage>();
+        std::shared_ptr<ExecutionReportMessage> message = pool ? pool->create() : std::make_shared<ExecutionReportMessage>();
         message->order = order;
         message->trade = nullptr;
         return message;
     };
 
     /** Creates an ExecutionReport message from the state of a post-trade order and the trade object. */
-    static std::shared_ptr<ExecutionReportMessage> createFromTrade(OrderPtr order, TradePtr trade)
+    static std::shared_ptr<ExecutionReportMessage> createFromTrade(OrderPtr order, TradePtr trade, ObjectPool<ExecutionReportMessage>* pool = nullptr)
     {
-        std::shared_ptr<ExecutionReportMessage> message = std::make_shared<ExecutionReportMessage>();
+        std::shared_ptr<ExecutionReportMessage> message = pool ? pool->create() : std::make_shared<ExecutionReportMessage>();
         message->order = order;
         message->trade = trade;
         return message;
     };
 
+    /** State of the order when the report was created. */
     OrderPtr order;
     TradePtr trade;
 
@@ -4,6 +4,7 @@
 #include "message.hpp"
 #include "messagetype.hpp"
 #include "../order/order.hpp"
+#include "../order/price.hpp"
 
 class LimitOrderMessage : public Message
 {
@@ -16,7 +17,7 @@ public:
     Order::Side side;
     Order::TimeInForce time_in_force;
     int quantity;
-    double price;
+    Price price;
     double priv_value;
 
 private:
@@ -0,0 +1,122 @@
+#ifndef MARKET_BY_ORDER_MESSAGE_HPP
+#define MARKET_BY_ORDER_MESSAGE_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+
+#include <boost/serialization/string.hpp>
+
+#include "message.hpp"
+#include "messagetype.hpp"
+#include "../trade/orderevent.hpp"
+
+/** Market by order update carrying consecutive order events of a single ticker. Events are numbered from
+ *  the sequence number of the first one, so subscribers can detect lost updates. To fit many events in a
+ *  datagram they are packed into bytes: a type and side byte, then varints of the order id and price as
+ *  differences from the previous event and of the quantity. */
+class MarketByOrderMessage : public Message
+{
+public:
+
+    /** Most events carried by a single message, keeping it well within a datagram. */
+    static constexpr size_t MAX_EVENTS = 2048;
+
+    MarketByOrderMessage() : Message(MessageType::MARKET_BY_ORDER) {};
+
+    std::string ticker;
+    unsigned long long sequence;
+    int count = 0;
+    std::string events;
+
+    /** Packs the given events into the message. */
+    void setEvents(std::vector<OrderEvent>::const_iterator first, std::vector<OrderEvent>::const_iterator last)
+    {
+        events.clear();
+        count = 0;
+        int previous_id = 0;
+        Price::Units previous_price = 0;
+        for (auto it = first; it != last; ++it, ++count)
+        {
+            events.push_back(static_cast<char>(static_cast<int>(it->type) << 1 | static_cast<int>(it->side)));
+            appendVarint(zigzag(static_cast<int64_t>(it->order_id) - previous_id));
+            appendVarint(zigzag(it->price.units() - previous_price));
+            appendVarint(static_cast<uint64_t>(it->quantity));
+            previous_id = it->order_id;
+            previous_price = it->price.units();
+        }
+    }
+
+    /** Unpacks the events carried by the message. */
+    std::vector<OrderEvent> getEvents() const
+    {
+        std::vector<OrderEvent> result;
+        result.reserve(count);
+        size_t position = 0;
+        int64_t order_id = 0;
+        Price::Units price = 0;
+        for (int i = 0; i < count; ++i)
+        {
+            if (position >= events.size()) throw std::runtime_error("Truncated market by order message");
+            uint8_t flags = static_cast<uint8_t>(events[position++]);
+            order_id += unzigzag(readVarint(position));
+            price += unzigzag(readVarint(position));
+            int quantity = static_cast<int>(readVarint(position));
+            result.push_back({static_cast<OrderEvent::Type>(flags >> 1), static_cast<Order::Side>(flags & 1),
+                static_cast<int>(order_id), Price::fromUnits(price), quantity});
+        }
+        return result;
+    }
+
+private:
+
+    static uint64_t zigzag(int64_t value)
+    {
+        return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    }
+
+    static int64_t unzigzag(uint64_t value)
+    {
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    void appendVarint(uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            events.push_back(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        events.push_back(static_cast<char>(value));
+    }
+
+    uint64_t readVarint(size_t& position) const
+    {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            if (position >= events.size()) throw std::runtime_error("Truncated market by order message");
+            uint8_t byte = static_cast<uint8_t>(events[position++]);
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) return value;
+        }
+        throw std::runtime_error("Malformed market by order message");
+    }
+
+    friend class boost::serialization::access;
+    template<class Archive>
+    void serialize(Archive & ar, const unsigned int version)
+    {
+        ar & boost::serialization::base_object<Message>(*this);
+        ar & ticker;
+        ar & sequence;
+        ar & count;
+        ar & events;
+    }
+
+};
+
+typedef std::shared_ptr<MarketByOrderMessage> MarketByOrderMessagePtr;
+
+#endif
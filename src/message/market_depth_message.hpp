@@ -0,0 +1,43 @@
+#ifndef MARKET_DEPTH_MESSAGE_HPP
+#define MARKET_DEPTH_MESSAGE_HPP
+
+#include <vector>
+
+#include "message.hpp"
+#include "messagetype.hpp"
+#include "../trade/marketdepth.hpp"
+
+/** Level 2 update listing the price levels changed within the subscribed depth since the previous update.
+ *  Sequence numbers are consecutive for each ticker and depth, so subscribers can detect lost updates. */
+class MarketDepthMessage : public Message
+{
+public:
+
+    /** Most level updates carried by a single message, keeping it well within a datagram. */
+    static constexpr size_t MAX_UPDATES = 1024;
+
+    MarketDepthMessage() : Message(MessageType::MARKET_DEPTH) {};
+
+    std::string ticker;
+    int depth;
+    unsigned long long sequence;
+    std::vector<DepthUpdate> updates;
+
+private:
+
+    friend class boost::serialization::access;
+    template<class Archive>
+    void serialize(Archive & ar, const unsigned int version)
+    {
+        ar & boost::serialization::base_object<Message>(*this);
+        ar & ticker;
+        ar & depth;
+        ar & sequence;
+        ar & updates;
+    }
+
+};
+
+typedef std::shared_ptr<MarketDepthMessage> MarketDepthMessagePtr;
+
+#endif
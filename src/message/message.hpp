@@ -65,6 +65,16 @@ public:
         return std::to_string(sender_id) + ","  + std::to_string(timestamp_sent) + "," + std::to_string(timestamp_received) + "," + std::to_string(timestamp_processed);
     }
 
+    TapeSchema const& describeTapeSchema() const override
+    {
+        return MessageRecord::schema();
+    }
+
+    void appendTapeRecord(std::string& buffer) const override
+    {
+        ::appendTapeRecord(buffer, MessageRecord{timestamp_sent, timestamp_received, timestamp_processed, sender_id});
+    }
+
     MessageType type;
     int sender_id;
     unsigned long long timestamp_sent;
@@ -12,7 +12,12 @@ enum class MessageType : int
     MARKET_ORDER,
     CANCEL_ORDER,
     EXECUTION_REPORT,
-    CANCEL_REJECT
+    CANCEL_REJECT,
+    MARKET_DEPTH,
+    MARKET_BY_ORDER,
+    SNAPSHOT_REQUEST,
+    SNAPSHOT,
+    MULTICAST_GROUP
 };
 
 #endif
\ No newline at end of file
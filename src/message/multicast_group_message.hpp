@@ -0,0 +1,32 @@
+#ifndef MULTICAST_GROUP_MESSAGE_HPP
+#define MULTICAST_GROUP_MESSAGE_HPP
+
+#include "message.hpp"
+#include "messagetype.hpp"
+
+/** Sent by the exchange in reply to a subscription to a ticker whose market data is published by multicast. */
+class MulticastGroupMessage : public Message
+{
+public:
+
+    MulticastGroupMessage() : Message(MessageType::MULTICAST_GROUP) {};
+
+    std::string ticker;
+    std::string group;               // Address and port of the group to join
+
+private:
+
+    friend class boost::serialization::access;
+    template<class Archive>
+    void serialize(Archive & ar, const unsigned int version)
+    {
+        ar & boost::serialization::base_object<Message>(*this);
+        ar & ticker;
+        ar & group;
+    }
+
+};
+
+typedef std::shared_ptr<MulticastGroupMessage> MulticastGroupMessagePtr;
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef SNAPSHOT_MESSAGE_HPP
+#define SNAPSHOT_MESSAGE_HPP
+
+#include <vector>
+
+#include "message.hpp"
+#include "messagetype.hpp"
+#include "subscribe_message.hpp"
+#include "../trade/marketdata.hpp"
+#include "../trade/marketdepth.hpp"
+#include "../trade/orderevent.hpp"
+
+/** Image of a ticker's book as seen by a feed, taken between two inbound messages. The book is
+ *  as it stood after the update with the given sequence number, so subscribers apply the updates
+ *  following it. Level 2 snapshots list the levels within the depth and market by order snapshots
+ *  list resting orders as ADD events, in priority order. */
+class SnapshotMessage : public Message
+{
+public:
+
+    SnapshotMessage() : Message(MessageType::SNAPSHOT) {};
+
+    std::string ticker;
+    SubscribeMessage::Feed feed;
+    int depth;
+    unsigned long long sequence;
+    MarketDataPtr data;
+    std::vector<DepthUpdate> levels;
+    std::vector<OrderEvent> orders;
+
+private:
+
+    friend class boost::serialization::access;
+    template<class Archive>
+    void serialize(Archive & ar, const unsigned int version)
+    {
+        ar & boost::serialization::base_object<Message>(*this);
+        ar & ticker;
+        ar & feed;
+        ar & depth;
+        ar & sequence;
+        ar & data;
+        ar & levels;
+        ar & orders;
+    }
+
+};
+
+typedef std::shared_ptr<SnapshotMessage> SnapshotMessagePtr;
+
+#endif
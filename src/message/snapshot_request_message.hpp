@@ -0,0 +1,35 @@
+#ifndef SNAPSHOT_REQUEST_MESSAGE_HPP
+#define SNAPSHOT_REQUEST_MESSAGE_HPP
+
+#include "message.hpp"
+#include "messagetype.hpp"
+#include "subscribe_message.hpp"
+
+/** Asks the exchange for a snapshot of a ticker's book as seen by the given feed. */
+class SnapshotRequestMessage : public Message
+{
+public:
+
+    SnapshotRequestMessage() : Message(MessageType::SNAPSHOT_REQUEST) {};
+
+    std::string ticker;
+    SubscribeMessage::Feed feed = SubscribeMessage::Feed::LEVEL_1;
+    int depth = 0;
+
+private:
+
+    friend class boost::serialization::access;
+    template<class Archive>
+    void serialize(Archive & ar, const unsigned int version)
+    {
+        ar & boost::serialization::base_object<Message>(*this);
+        ar & ticker;
+        ar & feed;
+        ar & depth;
+    }
+
+};
+
+typedef std::shared_ptr<SnapshotRequestMessage> SnapshotRequestMessagePtr;
+
+#endif
@@ -8,10 +8,19 @@ class SubscribeMessage : public Message
 {
 public:
 
+    /** The market data feed sent to the subscriber. */
+    enum class Feed: int {
+        LEVEL_1,                     // Best prices and totals after every change
+        LEVEL_2,                     // Changed price levels within the subscribed depth
+        MARKET_BY_ORDER              // Adds, executions and deletions of individual orders
+    };
+
     SubscribeMessage() : Message(MessageType::SUBSCRIBE) {};
 
     std::string ticker;
     std::string address;
+    Feed feed = Feed::LEVEL_1;
+    int depth = 0;                   // Price levels per side on the level 2 feed, 0 for the full book
 
 private:
 
@@ -22,6 +31,8 @@ private:
         ar & boost::serialization::base_object<Message>(*this);
         ar & ticker;
         ar & address;
+        ar & feed;
+        ar & depth;
     }
 
 };
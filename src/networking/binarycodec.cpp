@@ -0,0 +1,579 @@
+#include <cstddef>
+
+#include "binarycodec.hpp"
+#include "../order/limitorder.hpp"
+#include "../order/marketorder.hpp"
+#include "../trade/trade.hpp"
+#include "../trade/marketdata.hpp"
+#include "../trade/marketdepth.hpp"
+#include "../trade/orderevent.hpp"
+#include "../message/market_data_message.hpp"
+#include "../message/subscribe_message.hpp"
+#include "../message/limit_order_message.hpp"
+#include "../message/market_order_message.hpp"
+#include "../message/cancel_order_message.hpp"
+#include "../message/event_message.hpp"
+#include "../message/cancel_reject_message.hpp"
+#include "../message/exec_report_message.hpp"
+#include "../message/market_depth_message.hpp"
+#include "../message/market_by_order_message.hpp"
+#include "../message/snapshot_request_message.hpp"
+#include "../message/snapshot_message.hpp"
+#include "../message/multicast_group_message.hpp"
+
+static MarketDataBody encodeMarketData(MarketData const& data)
+{
+    MarketDataBody body {};
+    body.timestamp = data.timestamp;
+    body.best_bid = data.best_bid;
+    body.best_ask = data.best_ask;
+    body.last_price_traded = data.last_price_traded;
+    body.high_price = data.high_price;
+    body.low_price = data.low_price;
+    body.best_bid_size = data.best_bid_size;
+    body.best_ask_size = data.best_ask_size;
+    body.bids_volume = data.bids_volume;
+    body.asks_volume = data.asks_volume;
+    body.bids_count = data.bids_count;
+    body.asks_count = data.asks_count;
+    body.last_quantity_traded = data.last_quantity_traded;
+    body.cumulative_volume_traded = data.cumulative_volume_traded;
+    body.trades_count = data.trades_count;
+    copyWireText(body.ticker, data.ticker);
+    return body;
+}
+
+static void decodeMarketData(MarketDataBody const& body, MarketDataPtr& data)
+{
+    if (data == nullptr)
+    {
+        data = std::make_shared<MarketData>();
+    }
+    data->timestamp = body.timestamp;
+    data->best_bid = body.best_bid;
+    data->best_ask = body.best_ask;
+    data->last_price_traded = body.last_price_traded;
+    data->high_price = body.high_price;
+    data->low_price = body.low_price;
+    data->best_bid_size = body.best_bid_size;
+    data->best_ask_size = body.best_ask_size;
+    data->bids_volume = body.bids_volume;
+    data->asks_volume = body.asks_volume;
+    data->bids_count = body.bids_count;
+    data->asks_count = body.asks_count;
+    data->last_quantity_traded = body.last_quantity_traded;
+    data->cumulative_volume_traded = body.cumulative_volume_traded;
+    data->trades_count = body.trades_count;
+    readWireText(body.ticker, data->ticker);
+}
+
+static void writeLevels(std::vector<DepthUpdate> const& levels, WireWriter& writer)
+{
+    for (DepthUpdate const& level : levels)
+    {
+        writer.put(DepthLevelRecord{level.price, level.size, static_cast<uint8_t>(level.side), static_cast<uint8_t>(level.action), 0});
+    }
+}
+
+static void readLevels(WireReader& reader, uint32_t count, std::vector<DepthUpdate>& levels)
+{
+    // Check the levels are all there before sizing the vector after them
+    WireReader records {reader.getBytes(static_cast<size_t>(count) * sizeof(DepthLevelRecord))};
+    levels.resize(count);
+    for (DepthUpdate& level : levels)
+    {
+        DepthLevelRecord record = records.get<DepthLevelRecord>();
+        level = DepthUpdate{static_cast<Order::Side>(record.side), record.price, record.size, static_cast<DepthUpdate::Action>(record.action)};
+    }
+}
+
+bool BinaryCodec::canEncode(MessageType type)
+{
+    switch (type)
+    {
+        case MessageType::MARKET_DATA:
+        case MessageType::SUBSCRIBE:
+        case MessageType::LIMIT_ORDER:
+        case MessageType::MARKET_ORDER:
+        case MessageType::CANCEL_ORDER:
+        case MessageType::EVENT:
+        case MessageType::CANCEL_REJECT:
+        case MessageType::EXECUTION_REPORT:
+        case MessageType::MARKET_DEPTH:
+        case MessageType::MARKET_BY_ORDER:
+        case MessageType::SNAPSHOT_REQUEST:
+        case MessageType::SNAPSHOT:
+        case MessageType::MULTICAST_GROUP:
+            return true;
+        default:
+            return false;
+    }
+}
+
+size_t BinaryCodec::encode(Message const& message, std::string& bytes)
+{
+    WireWriter writer {bytes};
+    write(message, writer);
+
+    // The length is only known once the body is written
+    if (writer.size() > WireHeader::MAX_LENGTH)
+    {
+        throw std::runtime_error("Binary message of " + std::to_string(writer.size()) + " bytes is too long to send");
+    }
+    uint32_t length = static_cast<uint32_t>(writer.size());
+    std::memcpy(writer.begin() + offsetof(WireHeader, length), &length, sizeof(length));
+    return writer.size();
+}
+
+void BinaryCodec::write(Message const& message, WireWriter& writer)
+{
+    WireHeader header {};
+    header.magic = WireHeader::MAGIC;
+    header.version = WireHeader::VERSION;
+    header.type = static_cast<uint16_t>(message.type);
+    header.sender_id = message.sender_id;
+    header.timestamp_sent = message.timestamp_sent;
+    header.timestamp_received = message.timestamp_received;
+    header.timestamp_processed = message.timestamp_processed;
+    writer.put(header);
+
+    switch (message.type)
+    {
+        case MessageType::MARKET_DATA:
+        {
+            MarketDataMessage const& msg = static_cast<MarketDataMessage const&>(message);
+            writer.put(encodeMarketData(*msg.data));
+            break;
+        }
+        case MessageType::SUBSCRIBE:
+        {
+            SubscribeMessage const& msg = static_cast<SubscribeMessage const&>(message);
+            SubscribeBody body {};
+            body.feed = static_cast<int32_t>(msg.feed);
+            body.depth = msg.depth;
+            copyWireText(body.ticker, msg.ticker);
+            copyWireText(body.address, msg.address);
+            writer.put(body);
+            break;
+        }
+        case MessageType::LIMIT_ORDER:
+        {
+            LimitOrderMessage const& msg = static_cast<LimitOrderMessage const&>(message);
+            LimitOrderBody body {};
+            body.price = msg.price;
+            body.priv_value = msg.priv_value;
+            body.client_order_id = msg.client_order_id;
+            body.side = static_cast<int32_t>(msg.side);
+            body.time_in_force = static_cast<int32_t>(msg.time_in_force);
+            body.quantity = msg.quantity;
+            copyWireText(body.ticker, msg.ticker);
+            writer.put(body);
+            break;
+        }
+        case MessageType::MARKET_ORDER:
+        {
+            MarketOrderMessage const& msg = static_cast<MarketOrderMessage const&>(message);
+            MarketOrderBody body {};
+            body.priv_value = msg.priv_value;
+            body.client_order_id = msg.client_order_id;
+            body.side = static_cast<int32_t>(msg.side);
+            body.quantity = msg.quantity;
+            copyWireText(body.ticker, msg.ticker);
+            writer.put(body);
+            break;
+        }
+        case MessageType::CANCEL_ORDER:
+        {
+            CancelOrderMessage const& msg = static_cast<CancelOrderMessage const&>(message);
+            CancelOrderBody body {};
+            body.order_id = msg.order_id;
+            body.side = static_cast<int32_t>(msg.side);
+            copyWireText(body.ticker, msg.ticker);
+            writer.put(body);
+            break;
+        }
+        case MessageType::EVENT:
+        {
+            EventMessage const& msg = static_cast<EventMessage const&>(message);
+            writer.put(EventBody{static_cast<int32_t>(msg.event_type), 0});
+            break;
+        }
+        case MessageType::CANCEL_REJECT:
+        {
+            CancelRejectMessage const& msg = static_cast<CancelRejectMessage const&>(message);
+            writer.put(CancelRejectBody{msg.order_id, 0});
+            break;
+        }
+        case MessageType::EXECUTION_REPORT:
+        {
+            ExecutionReportMessage const& msg = static_cast<ExecutionReportMessage const&>(message);
+            writer.put(ExecutionReportBody{msg.order != nullptr, msg.trade != nullptr});
+            if (msg.order != nullptr)
+            {
+                Order const& order = *msg.order;
+                OrderBody body {};
+                if (order.type == Order::Type::LIMIT)
+                {
+                    body.price = static_cast<LimitOrder const&>(order).price;
+                }
+                body.avg_price = order.avg_price;
+                body.priv_value = order.priv_value;
+                body.timestamp_sent = order.timestamp_sent;
+                body.timestamp_received = order.timestamp_received;
+                body.timestamp_created = order.timestamp_created;
+                body.timestamp_executed = order.timestamp_executed;
+                body.id = order.id;
+                body.client_order_id = order.client_order_id;
+                body.type = static_cast<int32_t>(order.type);
+                body.time_in_force = static_cast<int32_t>(order.time_in_force);
+                body.status = static_cast<int32_t>(order.status);
+                body.side = static_cast<int32_t>(order.side);
+                body.remaining_quantity = order.remaining_quantity;
+                body.cumulative_quantity = order.cumulative_quantity;
+                copyWireText(body.ticker, order.ticker);
+                writer.put(body);
+            }
+            if (msg.trade != nullptr)
+            {
+                Trade const& trade = *msg.trade;
+                TradeBody body {};
+                body.price = trade.price;
+                body.buyer_priv_value = trade.buyer_priv_value;
+                body.seller_priv_value = trade.seller_priv_value;
+                body.timestamp = trade.timestamp;
+                body.id = trade.id;
+                body.quantity = trade.quantity;
+                body.buyer_id = trade.buyer_id;
+                body.seller_id = trade.seller_id;
+                body.aggressing_order_id = trade.aggressing_order_id;
+                body.resting_order_id = trade.resting_order_id;
+                copyWireText(body.ticker, trade.ticker);
+                writer.put(body);
+            }
+            break;
+        }
+        case MessageType::MARKET_DEPTH:
+        {
+            MarketDepthMessage const& msg = static_cast<MarketDepthMessage const&>(message);
+            MarketDepthBody body {};
+            body.sequence = msg.sequence;
+            body.depth = msg.depth;
+            body.level_count = static_cast<uint32_t>(msg.updates.size());
+            copyWireText(body.ticker, msg.ticker);
+            writer.put(body);
+            writeLevels(msg.updates, writer);
+            break;
+        }
+        case MessageType::MARKET_BY_ORDER:
+        {
+            MarketByOrderMessage const& msg = static_cast<MarketByOrderMessage const&>(message);
+            MarketByOrderBody body {};
+            body.sequence = msg.sequence;
+            body.count = msg.count;
+            body.event_bytes = static_cast<uint32_t>(msg.events.size());
+            copyWireText(body.ticker, msg.ticker);
+            writer.put(body);
+            writer.putBytes(msg.events.data(), msg.events.size());
+            break;
+        }
+        case MessageType::SNAPSHOT_REQUEST:
+        {
+            SnapshotRequestMessage const& msg = static_cast<SnapshotRequestMessage const&>(message);
+            SnapshotRequestBody body {};
+            body.feed = static_cast<int32_t>(msg.feed);
+            body.depth = msg.depth;
+            copyWireText(body.ticker, msg.ticker);
+            writer.put(body);
+            break;
+        }
+        case MessageType::SNAPSHOT:
+        {
+            SnapshotMessage const& msg = static_cast<SnapshotMessage const&>(message);
+            SnapshotBody body {};
+            body.sequence = msg.sequence;
+            body.feed = static_cast<int32_t>(msg.feed);
+            body.depth = msg.depth;
+            body.level_count = static_cast<uint32_t>(msg.levels.size());
+            body.order_count = static_cast<uint32_t>(msg.orders.size());
+            body.has_data = msg.data != nullptr;
+            copyWireText(body.ticker, msg.ticker);
+            writer.put(body);
+            if (msg.data != nullptr)
+            {
+                writer.put(encodeMarketData(*msg.data));
+            }
+            writeLevels(msg.levels, writer);
+            for (OrderEvent const& order : msg.orders)
+            {
+                writer.put(OrderEventRecord{order.price, order.order_id, order.quantity, static_cast<uint8_t>(order.type), static_cast<uint8_t>(order.side), 0, 0});
+            }
+            break;
+        }
+        case MessageType::MULTICAST_GROUP:
+        {
+            MulticastGroupMessage const& msg = static_cast<MulticastGroupMessage const&>(message);
+            MulticastGroupBody body {};
+            copyWireText(body.ticker, msg.ticker);
+            copyWireText(body.group, msg.group);
+            writer.put(body);
+            break;
+        }
+        default:
+        {
+            throw std::runtime_error("Messages of type " + std::to_string(static_cast<int>(message.type)) + " have no binary layout");
+        }
+    }
+}
+
+MessagePtr BinaryCodec::decode(std::string_view bytes)
+{
+    WireReader reader {bytes};
+    WireHeader header = reader.get<WireHeader>();
+    MessagePtr message = create(static_cast<MessageType>(header.type));
+    decode(bytes, *message);
+    return message;
+}
+
+void BinaryCodec::decode(std::string_view bytes, Message& message)
+{
+    WireReader reader {bytes};
+    WireHeader header = reader.get<WireHeader>();
+    if (header.magic != WireHeader::MAGIC || header.version != WireHeader::VERSION)
+    {
+        throw std::runtime_error("Unsupported binary message version " + std::to_string(header.version));
+    }
+    if (static_cast<MessageType>(header.type) != message.type)
+    {
+        throw std::runtime_error("Binary message of type " + std::to_string(header.type) + " decoded into a message of another type");
+    }
+    if (header.length > bytes.size())
+    {
+        throw std::runtime_error("Binary message is truncated");
+    }
+    message.sender_id = header.sender_id;
+    message.timestamp_sent = header.timestamp_sent;
+    message.timestamp_received = header.timestamp_received;
+    message.timestamp_processed = header.timestamp_processed;
+
+    switch (message.type)
+    {
+        case MessageType::MARKET_DATA:
+        {
+            MarketDataMessage& msg = static_cast<MarketDataMessage&>(message);
+            decodeMarketData(reader.get<MarketDataBody>(), msg.data);
+            break;
+        }
+        case MessageType::SUBSCRIBE:
+        {
+            SubscribeMessage& msg = static_cast<SubscribeMessage&>(message);
+            SubscribeBody body = reader.get<SubscribeBody>();
+            msg.feed = static_cast<SubscribeMessage::Feed>(body.feed);
+            msg.depth = body.depth;
+            readWireText(body.ticker, msg.ticker);
+            readWireText(body.address, msg.address);
+            break;
+        }
+        case MessageType::LIMIT_ORDER:
+        {
+            LimitOrderMessage& msg = static_cast<LimitOrderMessage&>(message);
+            LimitOrderBody body = reader.get<LimitOrderBody>();
+            msg.price = body.price;
+            msg.priv_value = body.priv_value;
+            msg.client_order_id = body.client_order_id;
+            msg.side = static_cast<Order::Side>(body.side);
+            msg.time_in_force = static_cast<Order::TimeInForce>(body.time_in_force);
+            msg.quantity = body.quantity;
+            readWireText(body.ticker, msg.ticker);
+            break;
+        }
+        case MessageType::MARKET_ORDER:
+        {
+            MarketOrderMessage& msg = static_cast<MarketOrderMessage&>(message);
+            MarketOrderBody body = reader.get<MarketOrderBody>();
+            msg.priv_value = body.priv_value;
+            msg.client_order_id = body.client_order_id;
+            msg.side = static_cast<Order::Side>(body.side);
+            msg.quantity = body.quantity;
+            readWireText(body.ticker, msg.ticker);
+            break;
+        }
+        case MessageType::CANCEL_ORDER:
+        {
+            CancelOrderMessage& msg = static_cast<CancelOrderMessage&>(message);
+            CancelOrderBody body = reader.get<CancelOrderBody>();
+            msg.order_id = body.order_id;
+            msg.side = static_cast<Order::Side>(body.side);
+            readWireText(body.ticker, msg.ticker);
+            break;
+        }
+        case MessageType::EVENT:
+        {
+            static_cast<EventMessage&>(message).event_type = static_cast<EventMessage::EventType>(reader.get<EventBody>().event_type);
+            break;
+        }
+        case MessageType::CANCEL_REJECT:
+        {
+            static_cast<CancelRejectMessage&>(message).order_id = reader.get<CancelRejectBody>().order_id;
+            break;
+        }
+        case MessageType::EXECUTION_REPORT:
+        {
+            ExecutionReportMessage& msg = static_cast<ExecutionReportMessage&>(message);
+            ExecutionReportBody report = reader.get<ExecutionReportBody>();
+            if (!report.has_order)
+            {
+                msg.order = nullptr;
+            }
+            else
+            {
+                OrderBody body = reader.get<OrderBody>();
+                Order::Type type = static_cast<Order::Type>(body.type);
+
+                // Reuse the order of the given message if it is of the same type
+                if (msg.order == nullptr || msg.order->type != type)
+                {
+                    msg.order = (type == Order::Type::LIMIT) ? std::static_pointer_cast<Order>(std::make_shared<LimitOrder>())
+                                                             : std::static_pointer_cast<Order>(std::make_shared<MarketOrder>());
+                }
+                Order& order = *msg.order;
+                if (type == Order::Type::LIMIT)
+                {
+                    static_cast<LimitOrder&>(order).price = body.price;
+                }
+                order.avg_price = body.avg_price;
+                order.priv_value = body.priv_value;
+                order.timestamp_sent = body.timestamp_sent;
+                order.timestamp_received = body.timestamp_received;
+                order.timestamp_created = body.timestamp_created;
+                order.timestamp_executed = body.timestamp_executed;
+                order.id = body.id;
+                order.client_order_id = body.client_order_id;
+                order.type = type;
+                order.time_in_force = static_cast<Order::TimeInForce>(body.time_in_force);
+                order.status = static_cast<Order::Status>(body.status);
+                order.side = static_cast<Order::Side>(body.side);
+                order.remaining_quantity = body.remaining_quantity;
+                order.cumulative_quantity = body.cumulative_quantity;
+                readWireText(body.ticker, order.ticker);
+            }
+            if (!report.has_trade)
+            {
+                msg.trade = nullptr;
+            }
+            else
+            {
+                TradeBody body = reader.get<TradeBody>();
+                if (msg.trade == nullptr)
+                {
+                    msg.trade = std::make_shared<Trade>();
+                }
+                Trade& trade = *msg.trade;
+                trade.price = body.price;
+                trade.buyer_priv_value = body.buyer_priv_value;
+                trade.seller_priv_value = body.seller_priv_value;
+                trade.timestamp = body.timestamp;
+                trade.id = body.id;
+                trade.quantity = body.quantity;
+                trade.buyer_id = body.buyer_id;
+                trade.seller_id = body.seller_id;
+                trade.aggressing_order_id = body.aggressing_order_id;
+                trade.resting_order_id = body.resting_order_id;
+                readWireText(body.ticker, trade.ticker);
+            }
+            break;
+        }
+        case MessageType::MARKET_DEPTH:
+        {
+            MarketDepthMessage& msg = static_cast<MarketDepthMessage&>(message);
+            MarketDepthBody body = reader.get<MarketDepthBody>();
+            msg.sequence = body.sequence;
+            msg.depth = body.depth;
+            readWireText(body.ticker, msg.ticker);
+            readLevels(reader, body.level_count, msg.updates);
+            break;
+        }
+        case MessageType::MARKET_BY_ORDER:
+        {
+            MarketByOrderMessage& msg = static_cast<MarketByOrderMessage&>(message);
+            MarketByOrderBody body = reader.get<MarketByOrderBody>();
+            msg.sequence = body.sequence;
+            msg.count = body.count;
+            readWireText(body.ticker, msg.ticker);
+            std::string_view events = reader.getBytes(body.event_bytes);
+            msg.events.assign(events.data(), events.size());
+            break;
+        }
+        case MessageType::SNAPSHOT_REQUEST:
+        {
+            SnapshotRequestMessage& msg = static_cast<SnapshotRequestMessage&>(message);
+            SnapshotRequestBody body = reader.get<SnapshotRequestBody>();
+            msg.feed = static_cast<SubscribeMessage::Feed>(body.feed);
+            msg.depth = body.depth;
+            readWireText(body.ticker, msg.ticker);
+            break;
+        }
+        case MessageType::SNAPSHOT:
+        {
+            SnapshotMessage& msg = static_cast<SnapshotMessage&>(message);
+            SnapshotBody body = reader.get<SnapshotBody>();
+            msg.sequence = body.sequence;
+            msg.feed = static_cast<SubscribeMessage::Feed>(body.feed);
+            msg.depth = body.depth;
+            readWireText(body.ticker, msg.ticker);
+            if (body.has_data)
+            {
+                decodeMarketData(reader.get<MarketDataBody>(), msg.data);
+            }
+            else
+            {
+                msg.data = nullptr;
+            }
+            readLevels(reader, body.level_count, msg.levels);
+
+            WireReader records {reader.getBytes(static_cast<size_t>(body.order_count) * sizeof(OrderEventRecord))};
+            msg.orders.resize(body.order_count);
+            for (OrderEvent& order : msg.orders)
+            {
+                OrderEventRecord record = records.get<OrderEventRecord>();
+                order = OrderEvent{static_cast<OrderEvent::Type>(record.type), static_cast<Order::Side>(record.side), record.order_id, record.price, record.quantity};
+            }
+            break;
+        }
+        case MessageType::MULTICAST_GROUP:
+        {
+            MulticastGroupMessage& msg = static_cast<MulticastGroupMessage&>(message);
+            MulticastGroupBody body = reader.get<MulticastGroupBody>();
+            readWireText(body.ticker, msg.ticker);
+            readWireText(body.group, msg.group);
+            break;
+        }
+        default:
+        {
+            throw std::runtime_error("Messages of type " + std::to_string(static_cast<int>(message.type)) + " have no binary layout");
+        }
+    }
+}
+
+MessagePtr BinaryCodec::create(MessageType type)
+{
+    switch (type)
+    {
+        case MessageType::MARKET_DATA: return std::make_shared<MarketDataMessage>();
+        case MessageType::SUBSCRIBE: return std::make_shared<SubscribeMessage>();
+        case MessageType::LIMIT_ORDER: return std::make_shared<LimitOrderMessage>();
+        case MessageType::MARKET_ORDER: return std::make_shared<MarketOrderMessage>();
+        case MessageType::CANCEL_ORDER: return std::make_shared<CancelOrderMessage>();
+        case MessageType::EVENT: return std::make_shared<EventMessage>();
+        case MessageType::CANCEL_REJECT: return std::make_shared<CancelRejectMessage>();
+        case MessageType::EXECUTION_REPORT: return std::make_shared<ExecutionReportMessage>();
+        case MessageType::MARKET_DEPTH: return std::make_shared<MarketDepthMessage>();
+        case MessageType::MARKET_BY_ORDER: return std::make_shared<MarketByOrderMessage>();
+        case MessageType::SNAPSHOT_REQUEST: return std::make_shared<SnapshotRequestMessage>();
+        case MessageType::SNAPSHOT: return std::make_shared<SnapshotMessage>();
+        case MessageType::MULTICAST_GROUP: return std::make_shared<MulticastGroupMessage>();
+        default:
+        {
+            throw std::runtime_error("Messages of type " + std::to_string(static_cast<int>(type)) + " have no binary layout");
+        }
+    }
+}
@@ -0,0 +1,227 @@
+#ifndef BINARY_CODEC_HPP
+#define BINARY_CODEC_HPP
+
+#include <string>
+#include <string_view>
+
+#include "wireformat.hpp"
+#include "../order/price.hpp"
+#include "../message/message.hpp"
+#include "../message/messagetype.hpp"
+
+/** Body of a limit order message. */
+struct LimitOrderBody
+{
+    Price price;
+    double priv_value;
+    int32_t client_order_id;
+    int32_t side;
+    int32_t time_in_force;
+    int32_t quantity;
+    char ticker[16];
+};
+
+/** Body of a market order message. */
+struct MarketOrderBody
+{
+    double priv_value;
+    int32_t client_order_id;
+    int32_t side;
+    int32_t quantity;
+    int32_t reserved;
+    char ticker[16];
+};
+
+/** Body of a cancel order message. */
+struct CancelOrderBody
+{
+    int32_t order_id;
+    int32_t side;
+    char ticker[16];
+};
+
+/** Body of a cancel reject message. */
+struct CancelRejectBody
+{
+    int32_t order_id;
+    int32_t reserved;
+};
+
+/** Body of an event message. */
+struct EventBody
+{
+    int32_t event_type;
+    int32_t reserved;
+};
+
+/** Body of a subscribe message. */
+struct SubscribeBody
+{
+    int32_t feed;
+    int32_t depth;
+    char ticker[16];
+    char address[32];
+};
+
+/** Body of a snapshot request message. */
+struct SnapshotRequestBody
+{
+    int32_t feed;
+    int32_t depth;
+    char ticker[16];
+};
+
+/** Body of a multicast group message. */
+struct MulticastGroupBody
+{
+    char ticker[16];
+    char group[32];
+};
+
+/** Level 1 market data, the body of a market data message and part of a snapshot. */
+struct MarketDataBody
+{
+    uint64_t timestamp;
+    Price best_bid;
+    Price best_ask;
+    Price last_price_traded;
+    Price high_price;
+    Price low_price;
+    int32_t best_bid_size;
+    int32_t best_ask_size;
+    int32_t bids_volume;
+    int32_t asks_volume;
+    int32_t bids_count;
+    int32_t asks_count;
+    int32_t last_quantity_traded;
+    int32_t cumulative_volume_traded;
+    int32_t trades_count;
+    int32_t reserved;
+    char ticker[16];
+};
+
+/** Body of an execution report, followed by the order and then the trade if present. */
+struct ExecutionReportBody
+{
+    int32_t has_order;
+    int32_t has_trade;
+};
+
+/** An order within an execution report. */
+struct OrderBody
+{
+    Price price;                     // Limit orders only
+    double avg_price;
+    double priv_value;
+    uint64_t timestamp_sent;
+    uint64_t timestamp_received;
+    uint64_t timestamp_created;
+    uint64_t timestamp_executed;
+    int32_t id;
+    int32_t client_order_id;
+    int32_t type;
+    int32_t time_in_force;
+    int32_t status;
+    int32_t side;
+    int32_t remaining_quantity;
+    int32_t cumulative_quantity;
+    char ticker[16];
+};
+
+/** A trade within an execution report. */
+struct TradeBody
+{
+    Price price;
+    double buyer_priv_value;
+    double seller_priv_value;
+    uint64_t timestamp;
+    int32_t id;
+    int32_t quantity;
+    int32_t buyer_id;
+    int32_t seller_id;
+    int32_t aggressing_order_id;
+    int32_t resting_order_id;
+    char ticker[16];
+};
+
+/** Body of a level 2 update, followed by its price levels. */
+struct MarketDepthBody
+{
+    uint64_t sequence;
+    int32_t depth;
+    uint32_t level_count;
+    char ticker[16];
+};
+
+/** A price level of a level 2 update or snapshot. */
+struct DepthLevelRecord
+{
+    Price price;
+    int32_t size;
+    uint8_t side;
+    uint8_t action;
+    uint16_t reserved;
+};
+
+/** Body of a market by order update, followed by its packed order events. */
+struct MarketByOrderBody
+{
+    uint64_t sequence;
+    int32_t count;
+    uint32_t event_bytes;
+    char ticker[16];
+};
+
+/** Body of a snapshot, followed by its market data if present, its price levels and then its orders. */
+struct SnapshotBody
+{
+    uint64_t sequence;
+    int32_t feed;
+    int32_t depth;
+    uint32_t level_count;
+    uint32_t order_count;
+    int32_t has_data;
+    int32_t reserved;
+    char ticker[16];
+};
+
+/** A resting order of a market by order snapshot. */
+struct OrderEventRecord
+{
+    Price price;
+    int32_t order_id;
+    int32_t quantity;
+    uint8_t type;
+    uint8_t side;
+    uint16_t reserved;
+    uint32_t padding;
+};
+
+/** Encodes messages into fixed-layout binary messages and back, as an alternative to text archives.
+ *  Both directions work on caller-provided buffers and messages, so reused buffers spare any allocation. */
+class BinaryCodec
+{
+public:
+
+    /** Returns true if messages of the given type have a binary layout. Configuration messages are only sent as text. */
+    static bool canEncode(MessageType type);
+
+    /** Encodes the given message onto the end of the buffer in a single pass, returning the number of bytes written. */
+    static size_t encode(Message const& message, std::string& bytes);
+
+    /** Decodes the given binary message into a new message of its type. */
+    static MessagePtr decode(std::string_view bytes);
+
+    /** Decodes the given binary message into the given message, which must be of the encoded type. */
+    static void decode(std::string_view bytes, Message& message);
+
+private:
+
+    /** Writes the header and body of the given message. */
+    static void write(Message const& message, WireWriter& writer);
+
+    /** Creates an empty message of the given type. */
+    static MessagePtr create(MessageType type);
+};
+
+#endif
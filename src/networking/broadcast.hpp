@@ -0,0 +1,19 @@
+#ifndef BROADCAST_HPP
+#define BROADCAST_HPP
+
+#include <memory>
+#include <vector>
+
+#include "udpserver.hpp"
+#include "../message/message.hpp"
+
+/** A message broadcast to a list of endpoints, sent starting from the given position of the list and wrapping around,
+ *  so the list can be shared by every broadcast while no endpoint is always served first. */
+struct Broadcast
+{
+    MessagePtr message;
+    EndpointList endpoints;
+    size_t start = 0;
+};
+
+#endif
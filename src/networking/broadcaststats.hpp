@@ -0,0 +1,69 @@
+#ifndef BROADCAST_STATS_HPP
+#define BROADCAST_STATS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <ostream>
+
+/** Timings of the batched broadcasts sent by a UDP server. Written by the IO thread and safe to read from any other. */
+class BroadcastStats
+{
+public:
+
+    /** Records a batch sent to the given number of endpoints, of which some were sent one at a time or failed,
+     *  taking the given time from the first send to the last. */
+    void record(size_t endpoints, size_t fallback, size_t failed, std::chrono::steady_clock::duration fan_out)
+    {
+        unsigned long long nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(fan_out).count();
+        batches_.fetch_add(1, std::memory_order_relaxed);
+        datagrams_.fetch_add(endpoints, std::memory_order_relaxed);
+        fallback_.fetch_add(fallback, std::memory_order_relaxed);
+        failed_.fetch_add(failed, std::memory_order_relaxed);
+        total_fan_out_.fetch_add(nanoseconds, std::memory_order_relaxed);
+        if (nanoseconds > max_fan_out_.load(std::memory_order_relaxed))
+        {
+            max_fan_out_.store(nanoseconds, std::memory_order_relaxed);
+        }
+    }
+
+    /** Returns the number of batches sent. */
+    size_t batches() const { return batches_.load(std::memory_order_relaxed); }
+
+    /** Returns the number of datagrams sent across all batches. */
+    size_t datagrams() const { return datagrams_.load(std::memory_order_relaxed); }
+
+    /** Returns the number of datagrams sent one at a time after the socket stopped taking batches. */
+    size_t fallback() const { return fallback_.load(std::memory_order_relaxed); }
+
+    /** Returns the number of datagrams that failed to send. */
+    size_t failed() const { return failed_.load(std::memory_order_relaxed); }
+
+    /** Returns the mean time from the first to the last send of a batch in nanoseconds. */
+    unsigned long long meanFanOut() const
+    {
+        size_t count = batches();
+        return count == 0 ? 0 : total_fan_out_.load(std::memory_order_relaxed) / count;
+    }
+
+    /** Returns the longest time from the first to the last send of a batch in nanoseconds. */
+    unsigned long long maxFanOut() const { return max_fan_out_.load(std::memory_order_relaxed); }
+
+    /** Prints the broadcast timings. */
+    void report(std::ostream& os) const
+    {
+        os << "Broadcasts: " << batches() << " batches of " << datagrams() << " datagrams in total, "
+        << fallback() << " sent one at a time, " << failed() << " failed, fan-out " << meanFanOut()
+        << " ns mean, " << maxFanOut() << " ns max\n";
+    }
+
+private:
+
+    std::atomic<size_t> batches_ = 0;
+    std::atomic<size_t> datagrams_ = 0;
+    std::atomic<size_t> fallback_ = 0;
+    std::atomic<size_t> failed_ = 0;
+    std::atomic<unsigned long long> total_fan_out_ = 0;
+    std::atomic<unsigned long long> max_fan_out_ = 0;
+};
+
+#endif
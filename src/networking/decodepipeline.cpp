@@ -0,0 +1,107 @@
+#include <chrono>
+
+#include "decodepipeline.hpp"
+#include "../utilities/logger.hpp"
+
+DecodePipeline::DecodePipeline(size_t workers, Decoder decoder, Handler handler)
+: decoder_{std::move(decoder)},
+  handler_{std::move(handler)},
+  jobs_{},
+  streams_{},
+  workers_{}
+{
+    for (size_t i = 0; i < workers; ++i)
+    {
+        workers_.emplace_back(&DecodePipeline::work, this);
+    }
+}
+
+DecodePipeline::~DecodePipeline()
+{
+    jobs_.close();
+    for (std::thread& worker : workers_)
+    {
+        worker.join();
+    }
+}
+
+void DecodePipeline::submit(std::string const& sender, std::string_view bytes)
+{
+    std::chrono::system_clock::duration now = std::chrono::system_clock::now().time_since_epoch();
+
+    StreamPtr stream;
+    {
+        std::scoped_lock lock{streams_mutex_};
+        StreamPtr& entry = streams_[sender];
+        if (entry == nullptr)
+        {
+            entry = std::make_shared<Stream>();
+            entry->sender = sender;
+        }
+        stream = entry;
+    }
+
+    JobPtr job = std::make_shared<Job>();
+    job->stream = stream;
+    job->timestamp_received = std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+    job->bytes.assign(bytes);
+    {
+        std::scoped_lock lock{stream->mutex};
+        job->sequence = stream->next_submitted++;
+    }
+    jobs_.push(job);
+}
+
+void DecodePipeline::removeSender(std::string const& sender)
+{
+    std::scoped_lock lock{streams_mutex_};
+    streams_.erase(sender);
+}
+
+void DecodePipeline::work()
+{
+    while (true)
+    {
+        JobPtr job = jobs_.pop();
+        if (job == nullptr) return;
+
+        // A message that fails to decode still takes its turn, so the ones after it are not held back
+        MessagePtr message;
+        try
+        {
+            message = decoder_(job->bytes);
+            message->timestamp_received = job->timestamp_received;
+        }
+        catch (std::exception& e)
+        {
+            LOG_ERROR << "Failed to deserialise message from " << job->stream->sender;
+            LOG_ERROR << "Reason: " << e.what();
+        }
+
+        complete(job->stream, job->sequence, message);
+    }
+}
+
+void DecodePipeline::complete(StreamPtr const& stream, unsigned long long sequence, MessagePtr message)
+{
+    std::unique_lock lock{stream->mutex};
+    stream->decoded.emplace(sequence, message);
+    if (stream->handling) return;
+
+    // Only one worker at a time hands on the stream's messages, so they stay in order
+    stream->handling = true;
+    while (!stream->decoded.empty() && stream->decoded.begin()->first == stream->next_handled)
+    {
+        MessagePtr next = stream->decoded.begin()->second;
+        stream->decoded.erase(stream->decoded.begin());
+        ++stream->next_handled;
+
+        lock.unlock();
+        if (next != nullptr)
+        {
+            handler_(stream->sender, next);
+        }
+        lock.lock();
+    }
+    stream->handling = false;
+}
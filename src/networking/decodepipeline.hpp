@@ -0,0 +1,75 @@
+#ifndef DECODE_PIPELINE_HPP
+#define DECODE_PIPELINE_HPP
+
+#include <map>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+
+#include "../message/message.hpp"
+#include "../utilities/syncqueue.hpp"
+
+/** Decodes incoming messages on a pool of worker threads and hands them on in the order each sender sent them.
+ *  The IO threads only frame the bytes and stamp when they arrived, so decoding no longer limits the inbound rate. */
+class DecodePipeline
+{
+public:
+    typedef std::function<MessagePtr(std::string_view)> Decoder;
+    typedef std::function<void(std::string const&, MessagePtr)> Handler;
+
+    DecodePipeline(size_t workers, Decoder decoder, Handler handler);
+    ~DecodePipeline();
+
+    DecodePipeline(const DecodePipeline&) = delete;
+    DecodePipeline& operator=(const DecodePipeline&) = delete;
+
+    /** Queues the bytes of a message from the given sender to be decoded, stamping the time they were received. */
+    void submit(std::string const& sender, std::string_view bytes);
+
+    /** Forgets the given sender, so that a new connection from the same address starts afresh. */
+    void removeSender(std::string const& sender);
+
+private:
+
+    /** The messages from a single sender, decoded in any order and handed on in the order they were received. */
+    struct Stream
+    {
+        std::string sender;
+        std::mutex mutex;
+        unsigned long long next_submitted = 0;
+        unsigned long long next_handled = 0;
+        std::map<unsigned long long, MessagePtr> decoded;   // Messages waiting for their turn, null if they failed to decode
+        bool handling = false;                              // Whether a worker is handing on the stream's messages
+    };
+    typedef std::shared_ptr<Stream> StreamPtr;
+
+    /** The bytes of a message waiting to be decoded. */
+    struct Job
+    {
+        StreamPtr stream;
+        unsigned long long sequence;
+        unsigned long long timestamp_received;
+        std::string bytes;
+    };
+    typedef std::shared_ptr<Job> JobPtr;
+
+    /** Decodes queued messages until the pipeline is closed. */
+    void work();
+
+    /** Records the decoded message and, unless another worker already is, hands on every message whose turn has come. */
+    void complete(StreamPtr const& stream, unsigned long long sequence, MessagePtr message);
+
+    Decoder decoder_;
+    Handler handler_;
+    SyncQueue<JobPtr> jobs_;
+    std::mutex streams_mutex_;
+    std::unordered_map<std::string, StreamPtr> streams_;
+    std::vector<std::thread> workers_;
+};
+
+#endif
@@ -5,6 +5,8 @@
 #include <boost/serialization/optional.hpp>
 
 #include "networkentity.hpp"
+#include "binarycodec.hpp"
+#include "viewstreambuf.hpp"
 #include "../agent/agent.hpp"
 #include "../agent/agentfactory.hpp"
 #include "../message/message.hpp"
@@ -17,8 +19,14 @@
 #include "../message/cancel_order_message.hpp"
 #include "../message/event_message.hpp"
 #include "../message/cancel_reject_message.hpp"
+#include "../message/market_depth_message.hpp"
+#include "../message/market_by_order_message.hpp"
+#include "../message/snapshot_request_message.hpp"
+#include "../message/snapshot_message.hpp"
+#include "../message/multicast_group_message.hpp"
 #include "../message/config_message.hpp"
 #include "../message/config_ack_message.hpp"
+#include "../utilities/logger.hpp"
 #include "../order/order.hpp"
 #include "../order/limitorder.hpp"
 #include "../order/marketorder.hpp"
@@ -32,6 +40,11 @@ BOOST_CLASS_EXPORT(MarketOrderMessage);
 BOOST_CLASS_EXPORT(CancelOrderMessage);
 BOOST_CLASS_EXPORT(EventMessage);
 BOOST_CLASS_EXPORT(CancelRejectMessage);
+BOOST_CLASS_EXPORT(MarketDepthMessage);
+BOOST_CLASS_EXPORT(MarketByOrderMessage);
+BOOST_CLASS_EXPORT(SnapshotRequestMessage);
+BOOST_CLASS_EXPORT(SnapshotMessage);
+BOOST_CLASS_EXPORT(MulticastGroupMessage);
 
 /** TODO: This should be elsewhere */
 BOOST_CLASS_EXPORT(AgentConfig);
@@ -56,24 +69,72 @@ namespace archive = boost::archive;
 void NetworkEntity::start()
 {
     asio::co_spawn(io_context_, TCPServer::start(), asio::detached);
-    asio::co_spawn(io_context_, UDPServer::start(), asio::detached);
-    std::cout << "Listening on port " << port() << "...\n";
+    asio::co_spawn(UDPServer::strand(), UDPServer::start(), asio::detached);
+    LOG_INFO << "Listening on port " << port() << " with " << io_threads_ << " IO threads...";
 
+    // Connections each run on a strand of their own, so the threads can serve different connections at once
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < io_threads_; ++i)
+    {
+        threads.emplace_back([this](){ io_context_.run(); });
+    }
     io_context_.run();
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
 }
 
-std::string NetworkEntity::serialiseMessage(MessagePtr message)
+std::string NetworkEntity::serialiseMessage(MessagePtr message, WireFormat format)
 {
+    std::string bytes;
+    serialiseMessage(message, format, bytes);
+    return bytes;
+}
+
+void NetworkEntity::serialiseMessage(MessagePtr message, WireFormat format, std::string& bytes)
+{
+    bytes.clear();
+    if (format == WireFormat::BINARY && BinaryCodec::canEncode(message->type))
+    {
+        BinaryCodec::encode(*message, bytes);
+        return;
+    }
+
+    // Leave room for the header, then fill it in once the length of the archive is known
     std::stringstream ss;
-    archive::text_oarchive oa{ss};
-    oa << message;
-    return ss.str() + std::string{"#END#"};
+    TextHeader header {TextHeader::MAGIC, WireHeader::VERSION, 0, 0};
+    ss.write(reinterpret_cast<const char*>(&header), sizeof(TextHeader));
+    {
+        archive::text_oarchive oa{ss};
+        oa << message;
+    }
+
+    bytes = ss.str();
+    if (bytes.size() > WireHeader::MAX_LENGTH)
+    {
+        throw std::runtime_error("Text message of " + std::to_string(bytes.size()) + " bytes is too long to send");
+    }
+    header.length = static_cast<uint32_t>(bytes.size());
+    std::memcpy(bytes.data(), &header, sizeof(TextHeader));
 }
 
 MessagePtr NetworkEntity::deserialiseMessage(std::string_view message)
 {
-    std::stringstream ss{std::string{message}};
-    archive::text_iarchive ia{ss};
+    if (WireHeader::startsMessage(message))
+    {
+        return BinaryCodec::decode(message);
+    }
+
+    if (TextHeader::startsMessage(message))
+    {
+        message.remove_prefix(sizeof(TextHeader));
+    }
+
+    // Read the archive straight from the received bytes
+    ViewStreambuf buffer{message};
+    std::istream is{&buffer};
+    archive::text_iarchive ia{is};
     MessagePtr msg = std::make_shared<Message>();
     ia >> msg;
 
@@ -95,31 +156,157 @@ void NetworkEntity::connect(ipv4_view address, std::function<void()> const& call
 
 void NetworkEntity::sendBroadcast(ipv4_view address, MessagePtr message)
 {
-    std::pair<std::string, unsigned int> pair = splitAddress(address);
-    message->markSent(agent()->getAgentId());
-    asio::post(io_context_, [=, this](){
-        asio::co_spawn(this->io_context_, UDPServer::sendBroadcast(pair.first, pair.second, serialiseMessage(message)), asio::detached);
-    });
+    sendBroadcast(std::make_shared<const std::vector<udp::endpoint>>(1, resolveEndpoint(address)), message);
 }
 
 void NetworkEntity::sendMessage(ipv4_view address, MessagePtr message, bool async)
 {
     // If TCP connection exists with the given address, send the message
-    if (connections_.left.find(std::string{address}) != connections_.left.end())
+    TCPConnectionPtr connection = findConnection(address);
+    if (connection != nullptr)
     {
-        TCPConnectionPtr connection = connections_.left.at(std::string{address});
         message->markSent(agent()->getAgentId());
-        asio::post(io_context_, [=, this](){
-            asio::co_spawn(io_context_, TCPServer::sendMessage(connection, serialiseMessage(message), async), asio::detached);
+
+        // Runs straight away when already on the connection's strand
+        asio::dispatch(connection->socket().get_executor(), [=, this](){
+            TCPServer::sendMessage(connection, serialiseMessage(message, formatFor(connection)), async);
         });
-        
     }
     // Abort sending message if TCP connection cannot be found
     else 
     {
-        std::cout << "Message failed to send: no TCP connection with " << address << "\n";
+        LOG_WARN << "Message failed to send: no TCP connection with " << address;
+    }
+
+}
+
+void NetworkEntity::postMessage(ipv4_view address, MessagePtr message, bool async)
+{
+    TCPConnectionPtr connection = findConnection(address);
+    if (connection == nullptr)
+    {
+        LOG_WARN << "Message failed to send: no TCP connection with " << address;
+        return;
+    }
+
+    // Only the message finding the outbox idle schedules a send, which takes every message posted by then
+    message->markSent(agent()->getAgentId());
+    if (connection->post(message, async))
+    {
+        asio::dispatch(connection->socket().get_executor(), [connection, this](){
+            sendOutbox(connection);
+        });
+    }
+}
+
+void NetworkEntity::sendOutbox(TCPConnectionPtr connection)
+{
+    std::vector<MessagePtr>& messages = connection->sending();
+    bool flush = connection->takeOutbox(messages);
+    for (MessagePtr const& message : messages)
+    {
+        // Encoded straight into the write queue, into the buffer of a message already sent
+        serialiseMessage(message, formatFor(connection), connection->enqueueBuffer());
+    }
+    messages.clear();
+    TCPServer::sendQueued(connection, !flush);
+}
+
+void NetworkEntity::sendBroadcast(EndpointList endpoints, MessagePtr message)
+{
+    std::vector<Broadcast> broadcasts {Broadcast{message, std::move(endpoints)}};
+    sendBroadcasts(broadcasts);
+}
+
+void NetworkEntity::sendBroadcasts(std::vector<Broadcast>& broadcasts)
+{
+    for (Broadcast const& broadcast : broadcasts)
+    {
+        broadcast.message->markSent(agent()->getAgentId());
+    }
+
+    // Hand the broadcasts over by swapping vectors, so neither side reallocates once they have grown
+    std::unique_lock lock{broadcasts_mutex_};
+    if (pending_broadcasts_.empty())
+    {
+        pending_broadcasts_.swap(broadcasts);
+    }
+    else
+    {
+        std::move(broadcasts.begin(), broadcasts.end(), std::back_inserter(pending_broadcasts_));
+        broadcasts.clear();
     }
+    bool idle = !broadcasts_scheduled_;
+    broadcasts_scheduled_ = true;
+    lock.unlock();
+
+    if (idle)
+    {
+        asio::co_spawn(UDPServer::strand(), sendPendingBroadcasts(), asio::detached);
+    }
+}
+
+asio::awaitable<void> NetworkEntity::sendPendingBroadcasts()
+{
+    // A single coroutine sends the broadcasts in the order handed over, each to all of its endpoints before the next,
+    // so no endpoint is sent a numbered update before the previous one even while the socket is full
+    for (;;)
+    {
+        std::unique_lock lock{broadcasts_mutex_};
+        if (pending_broadcasts_.empty())
+        {
+            broadcasts_scheduled_ = false;
+            co_return;
+        }
+        sending_broadcasts_.swap(pending_broadcasts_);
+        lock.unlock();
+
+        for (Broadcast const& broadcast : sending_broadcasts_)
+        {
+            // Every recipient is sent the same bytes, so serialise each message once, into the buffer of the last
+            serialiseMessage(broadcast.message, wire_format_, broadcast_bytes_);
+            co_await UDPServer::sendBroadcast(broadcast.endpoints, broadcast.start, broadcast_bytes_);
+        }
+        sending_broadcasts_.clear();
+    }
+}
 
+void NetworkEntity::setMulticastInterface()
+{
+    asio::ip::address interface_address = asio::ip::make_address(addr());
+    asio::post(UDPServer::strand(), [interface_address, this](){
+        try
+        {
+            UDPServer::setMulticastInterface(interface_address);
+        }
+        catch (std::exception& e)
+        {
+            LOG_ERROR << "Failed to set the multicast interface to " << interface_address << ": " << e.what();
+        }
+    });
+}
+
+void NetworkEntity::joinMulticastGroup(ipv4_view group)
+{
+    udp::endpoint group_endpoint = resolveEndpoint(group);
+    asio::ip::address interface_address = asio::ip::make_address(addr());
+    asio::post(UDPServer::strand(), [group_endpoint, interface_address, this](){
+        try
+        {
+            UDPServer::joinGroup(group_endpoint, interface_address);
+            LOG_INFO << "Joined multicast group " << group_endpoint;
+        }
+        catch (std::exception& e)
+        {
+            LOG_ERROR << "Failed to join multicast group " << group_endpoint << ": " << e.what();
+        }
+    });
+}
+
+udp::endpoint NetworkEntity::resolveEndpoint(ipv4_view address)
+{
+    std::pair<std::string, unsigned int> pair = splitAddress(address);
+    return udp::endpoint(asio::ip::make_address(pair.first), pair.second);
 }
 
 std::string NetworkEntity::concatAddress(std::string_view address, unsigned int port)
@@ -136,13 +323,20 @@ std::pair<std::string, unsigned int> NetworkEntity::splitAddress(std::string_vie
 
 void NetworkEntity::addConnection(std::string_view address, unsigned int port, TCPConnectionPtr connection)
 {
-    std::cout << "New connection with " << address << ":" << port << "\n";
+    LOG_INFO << "New connection with " << address << ":" << port;
+    std::unique_lock lock{connections_mutex_};
     connections_.left.insert({concatAddress(address, port), connection});
 }
 
 void NetworkEntity::removeConnection(std::string_view address, unsigned int port)
 {
     std::string full_addr = concatAddress(address, port);
+    if (decode_pipeline_ != nullptr)
+    {
+        decode_pipeline_->removeSender(full_addr);
+    }
+
+    std::unique_lock lock{connections_mutex_};
     if (connections_.left.find(full_addr) != connections_.left.end())
     {
         connections_.left.erase(full_addr);
@@ -155,32 +349,72 @@ std::string NetworkEntity::handleMessage(std::string_view sender_adress, unsigne
     // std::cout << "Received message from " << sender_adress << ":" << sender_port << "\n";
     // std::cout << "Received message " << message << "\n";
 
+    // With a decode pipeline the IO thread only queues the message, which is decoded and handled by the workers
+    if (decode_pipeline_ != nullptr)
+    {
+        decode_pipeline_->submit(concatAddress(sender_adress, sender_port), message);
+        return std::string{};
+    }
+
     try     
     {
         MessagePtr msg = deserialiseMessage(message);
         msg->markReceived();
 
-        if (msg->type == MessageType::CONFIG)
+        std::string sender = concatAddress(sender_adress, sender_port);
+        std::optional<MessagePtr> response = deliverMessage(sender, msg);
+        if (response.has_value()) 
         {
-            configureEntity(sender_adress, std::dynamic_pointer_cast<ConfigMessage>(msg));
+            TCPConnectionPtr connection = findConnection(sender);
+            WireFormat format = connection != nullptr ? formatFor(connection) : wire_format_;
+            return serialiseMessage(response.value(), format);
+        }
+    }
+    catch (std::exception& e)
+    {
+        LOG_ERROR << "Failed to deserialise message from " << sender_adress;
+        LOG_ERROR << "Reason: " << e.what();
+        if (WireHeader::startsMessage(message) && message.size() >= sizeof(WireHeader))
+        {
+            WireHeader header;
+            std::memcpy(&header, message.data(), sizeof(WireHeader));
+            LOG_ERROR << "Binary message of " << message.size() << " bytes, type " << header.type;
         }
         else
         {
-            std::optional<MessagePtr> response = agent()->handleMessage(concatAddress(sender_adress, sender_port), msg);
-            if (response.has_value()) 
-            {
-                return serialiseMessage(response.value());
-            }
+            LOG_ERROR << "Text message of " << message.size() << " bytes";
         }
     }
-    catch (std::exception& e)
+
+    return std::string{};
+}
+
+std::optional<MessagePtr> NetworkEntity::deliverMessage(std::string const& sender, MessagePtr message)
+{
+    if (message->type == MessageType::CONFIG)
     {
-        std::cout << "Failed to deserialise message from " << sender_adress << "\n";
-        std::cout << "Reason: " << e.what() << "\n";
-        std::cout << "Message " << message << "\n";
+        configureEntity(splitAddress(sender).first, std::dynamic_pointer_cast<ConfigMessage>(message));
+        return std::nullopt;
     }
 
-    return std::string{};
+    return agent()->handleMessage(sender, message);
+}
+
+void NetworkEntity::handleDecodedMessage(std::string const& sender, MessagePtr message)
+{
+    try
+    {
+        std::optional<MessagePtr> response = deliverMessage(sender, message);
+        if (response.has_value())
+        {
+            sendMessage(sender, response.value(), false);
+        }
+    }
+    catch (std::exception& e)
+    {
+        LOG_ERROR << "Failed to handle message from " << sender;
+        LOG_ERROR << "Reason: " << e.what();
+    }
 }
 
 void NetworkEntity::handleBroadcast(std::string_view sender_adress, unsigned int sender_port, std::string_view message)
@@ -195,8 +429,8 @@ void NetworkEntity::handleBroadcast(std::string_view sender_adress, unsigned int
     }
     catch (std::exception& e)
     {
-        std::cout << "Failed to deserialise message from " << sender_adress << "\n";
-        std::cout << e.what() << "\n";
+        LOG_ERROR << "Failed to deserialise message from " << sender_adress;
+        LOG_ERROR << e.what();
     }
     
     return;
@@ -207,6 +441,38 @@ unsigned int NetworkEntity::port()
     return port_;
 }
 
+void NetworkEntity::setWireFormat(WireFormat format)
+{
+    wire_format_ = format;
+}
+
+void NetworkEntity::setIoThreads(size_t count)
+{
+    if (count == 0)
+    {
+        throw std::runtime_error("A network entity needs at least one IO thread");
+    }
+    io_threads_ = count;
+}
+
+void NetworkEntity::setDecodeThreads(size_t count)
+{
+    if (count == 0)
+    {
+        decode_pipeline_.reset();
+        return;
+    }
+
+    decode_pipeline_ = std::make_unique<DecodePipeline>(count,
+        [this](std::string_view bytes){ return deserialiseMessage(bytes); },
+        [this](std::string const& sender, MessagePtr message){ handleDecodedMessage(sender, message); });
+}
+
+WireFormat NetworkEntity::formatFor(TCPConnectionPtr connection)
+{
+    return (wire_format_ == WireFormat::TEXT || connection->peerFormat() == WireFormat::TEXT) ? WireFormat::TEXT : WireFormat::BINARY;
+}
+
 std::string NetworkEntity::addr()
 {
     if (!addr_.has_value())
@@ -241,8 +507,9 @@ std::shared_ptr<Agent> NetworkEntity::agent()
 
 void NetworkEntity::configureEntity(std::string_view sender_address, ConfigMessagePtr msg)
 {
-    // Set own address
+    // Set own address and wire format
     addr_ = splitAddress(msg->config->addr).first;
+    wire_format_ = msg->config->wire_format;
 
     // Initialise a new agent
     setAgent(AgentFactory::createAgent(this, msg->config));
@@ -252,12 +519,24 @@ void NetworkEntity::configureEntity(std::string_view sender_address, ConfigMessa
     // sendMessage(sender_address, std::static_pointer_cast<Message>(ack_msg), true);
 }
 
+NetworkEntity::TCPConnectionPtr NetworkEntity::findConnection(ipv4_view address)
+{
+    std::shared_lock lock{connections_mutex_};
+    auto connection = connections_.left.find(std::string{address});
+    return connection != connections_.left.end() ? connection->second : nullptr;
+}
+
 void NetworkEntity::closeConnections()
 {
+    std::unique_lock lock{connections_mutex_};
     for (auto connection : connections_.left)
     {
-        std::cout << "Closing connection with " << connection.first << "\n";
-        connection.second->close();
+        LOG_INFO << "Closing connection with " << connection.first;
+
+        // The socket may only be used on its strand
+        asio::dispatch(connection.second->socket().get_executor(), [connection = connection.second](){
+            connection->close();
+        });
     }
 
     connections_.clear();
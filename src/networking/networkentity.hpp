@@ -3,13 +3,20 @@
 
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <functional>
 #include <optional>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
 #include <boost/asio.hpp>
 #include <boost/bimap.hpp>
 
 #include "tcpserver.hpp"
 #include "udpserver.hpp"
+#include "broadcast.hpp"
+#include "wireformat.hpp"
+#include "decodepipeline.hpp"
 #include "../message/message.hpp"
 #include "../message/config_message.hpp"
 
@@ -52,21 +59,57 @@ public:
     {
     }
 
-    /** Starts both servers and listens for incoming connections. */
+    /** Starts both servers and listens for incoming connections, serving them on the configured number of IO threads. */
     virtual void start();
 
     /** Establishes a lasting TCP connection with the given IPv4 address. */
     void connect(ipv4_view address, std::function<void()> const& callback);
 
-    /** Sends a broadcast to the given IPv4 address. */
+    /** Sends a broadcast to the given IPv4 address, in order with the other broadcasts. */
     void sendBroadcast(ipv4_view address, MessagePtr message);
 
-    /** Sends a message to the given IPv4 address. */
+    /** Sends a message to the given IPv4 address. Unless async, it is written straight away when the connection is idle. */
     void sendMessage(ipv4_view address, MessagePtr message, bool async);
 
+    /** Posts a message to the given IPv4 address from any thread. Messages posted to a connection before its strand
+     *  picks them up are serialised and written together. Unless async, they are written straight away when the connection is idle. */
+    void postMessage(ipv4_view address, MessagePtr message, bool async);
+
+    /** Sends a broadcast to each of the given endpoints, serialising it only once. */
+    void sendBroadcast(EndpointList endpoints, MessagePtr message);
+
+    /** Sends each broadcast to its endpoints, handing the whole batch to the IO context at once. The broadcasts are
+     *  taken out of the given vector, which is left empty with its capacity kept for the caller's next batch. */
+    void sendBroadcasts(std::vector<Broadcast>& broadcasts);
+
+    /** Sends multicast broadcasts through the interface of the NetworkEntity's own address. */
+    void setMulticastInterface();
+
+    /** Joins the multicast group with the given IPv4 address on the interface of the NetworkEntity's own address. */
+    void joinMulticastGroup(ipv4_view group);
+
+    /** Resolves the given IPv4 address into a UDP endpoint, so it is only parsed once per destination. */
+    static udp::endpoint resolveEndpoint(ipv4_view address);
+
     /** Returns the listening port of the NetworkEntity. */
     unsigned int port();
 
+    /** Sets the format messages are sent in. Connections fall back to text if the other end sends text. */
+    void setWireFormat(WireFormat format);
+
+    /** Sets the number of threads serving network IO. Must be called before start. */
+    void setIoThreads(size_t count);
+
+    /** Decodes incoming messages on the given number of worker threads, or on the IO threads if none.
+     *  Must be called before start. */
+    void setDecodeThreads(size_t count);
+
+    /** Returns the timings of the batched broadcasts sent so far. */
+    using UDPServer::broadcastStats;
+
+    /** Returns the number of messages gathered into each TCP write so far. */
+    using TCPServer::writeStats;
+
     /** Returns the address of the NetworkEntity. Must be called after address is known. */
     std::string addr();
 
@@ -96,17 +139,39 @@ private:
     /** Handles an incoming UDP broadcast. */
     void handleBroadcast(std::string_view sender_adress, unsigned int sender_port, std::string_view message) override;
 
-    /** Serialises a message into a string to be sent. */
-    std::string serialiseMessage(MessagePtr message);
+    /** Serialises the messages posted to the connection into its queue and sends them. Runs on the connection's strand. */
+    void sendOutbox(TCPConnectionPtr connection);
+
+    /** Serialises and sends the broadcasts handed over until none is left. Runs on the UDP strand, started by
+     *  the hand-over finding it idle, so only one runs at a time. */
+    asio::awaitable<void> sendPendingBroadcasts();
+
+    /** Hands a decoded message from the given sender to the agent, or configures the entity with it. Returns the response. */
+    std::optional<MessagePtr> deliverMessage(std::string const& sender, MessagePtr message);
 
-    /** Deserialises incoming strings into messages. */
+    /** Handles a message decoded by the pipeline, sending any response back to the sender. */
+    void handleDecodedMessage(std::string const& sender, MessagePtr message);
+
+    /** Serialises a message into a string to be sent in the given format. Messages with no binary layout are sent as text. */
+    std::string serialiseMessage(MessagePtr message, WireFormat format);
+
+    /** Serialises a message into the given buffer in place of its contents, reusing its capacity. */
+    void serialiseMessage(MessagePtr message, WireFormat format, std::string& bytes);
+
+    /** Deserialises incoming strings into messages, whichever format they are in. */
     MessagePtr deserialiseMessage(std::string_view message);
 
+    /** Returns the open connection with the given address, or null if there is none. */
+    TCPConnectionPtr findConnection(ipv4_view address);
+
+    /** Returns the format to send messages in over the given connection: text if either end prefers it. */
+    WireFormat formatFor(TCPConnectionPtr connection);
+
     /** Combines IP address with port into a single string. */
     std::string concatAddress(std::string_view address, unsigned int port);
 
     /** Splits a combined address into IP address and port. */
-    std::pair<std::string, unsigned int> splitAddress(ipv4_view address);
+    static std::pair<std::string, unsigned int> splitAddress(ipv4_view address);
 
     /** The IO context used for networking. */
     asio::io_context& io_context_;
@@ -114,6 +179,23 @@ private:
     /** The bidirectional map of currently open TCP connections. */
     bimap connections_;
 
+    /** Guards the map of connections, which IO threads and agent threads use at once. */
+    std::shared_mutex connections_mutex_;
+
+    /** Broadcasts handed over by agent threads and not yet taken by the UDP strand, guarded by the mutex. */
+    std::mutex broadcasts_mutex_;
+    std::vector<Broadcast> pending_broadcasts_;
+    bool broadcasts_scheduled_ = false;
+
+    /** Broadcasts taken by the UDP strand, which keeps the vector to reuse its capacity. */
+    std::vector<Broadcast> sending_broadcasts_;
+
+    /** The broadcast being sent, serialised by the UDP strand into the same buffer every time. */
+    std::string broadcast_bytes_;
+
+    /** The number of threads running the IO context. */
+    size_t io_threads_ = 1;
+
     /** The port of this NetworkEntity. */
     unsigned int port_;
 
@@ -122,6 +204,12 @@ private:
 
     /** Pointer to an Agent. May be empty before agent is initialised. */
     std::optional<std::shared_ptr<Agent>> agent_;
+
+    /** The format this NetworkEntity prefers to send messages in. */
+    WireFormat wire_format_ = WireFormat::BINARY;
+
+    /** Decodes incoming messages off the IO threads, if enabled. Declared last so its workers stop first. */
+    std::unique_ptr<DecodePipeline> decode_pipeline_;
 };
 
 
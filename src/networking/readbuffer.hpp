@@ -0,0 +1,66 @@
+#ifndef READ_BUFFER_HPP
+#define READ_BUFFER_HPP
+
+#include <vector>
+#include <cstring>
+#include <string_view>
+#include <boost/asio.hpp>
+
+namespace asio = boost::asio;
+
+/** Holds the bytes read from a stream until they are consumed, reusing the same storage for every read.
+ *  Consumed bytes are dropped by moving the rest to the front before the next read, so each message stays contiguous. */
+class ReadBuffer
+{
+public:
+
+    static constexpr size_t INITIAL_CAPACITY = 64 * 1024;
+
+    ReadBuffer()
+    : storage_(INITIAL_CAPACITY),
+      begin_{0},
+      end_{0}
+    {
+    }
+
+    /** Returns the bytes read but not yet consumed, valid until the next call to prepare. */
+    std::string_view data() const { return {storage_.data() + begin_, end_ - begin_}; }
+
+    /** Returns the free space after the unconsumed bytes, growing the buffer so it holds at least the given number of bytes. */
+    asio::mutable_buffer prepare(size_t size)
+    {
+        if (begin_ > 0)
+        {
+            std::memmove(storage_.data(), storage_.data() + begin_, end_ - begin_);
+            end_ -= begin_;
+            begin_ = 0;
+        }
+        if (storage_.size() - end_ < size)
+        {
+            storage_.resize(end_ + size);
+        }
+        return asio::buffer(storage_.data() + end_, storage_.size() - end_);
+    }
+
+    /** Marks the given number of bytes read into the space from prepare as received. */
+    void commit(size_t size) { end_ += size; }
+
+    /** Drops the given number of bytes from the front of the received bytes. */
+    void consume(size_t size)
+    {
+        begin_ += size;
+        if (begin_ == end_)
+        {
+            begin_ = 0;
+            end_ = 0;
+        }
+    }
+
+private:
+
+    std::vector<char> storage_;
+    size_t begin_;
+    size_t end_;
+};
+
+#endif
@@ -3,38 +3,129 @@
 #include <boost/system.hpp>
 
 #include "tcpconnection.hpp"
+#include "../utilities/logger.hpp"
 
 namespace asio = boost::asio;
 
-asio::awaitable<void> TCPConnection::send(std::string_view message, bool async)
+void TCPConnection::enqueue(std::string message)
 {
-    try {
-        // Push message to queue
-        queue_.push(std::string{message});
+    queue_.push_back(std::move(message));
+}
+
+std::string& TCPConnection::enqueueBuffer()
+{
+    if (spare_buffers_.empty())
+    {
+        return queue_.emplace_back();
+    }
+    std::string& buffer = queue_.emplace_back(std::move(spare_buffers_.back()));
+    spare_buffers_.pop_back();
+    return buffer;
+}
+
+void TCPConnection::notify()
+{
+    timer_.cancel_one();
+}
+
+bool TCPConnection::post(std::shared_ptr<Message> message, bool async)
+{
+    std::lock_guard lock{outbox_mutex_};
+    outbox_.push_back(std::move(message));
+    outbox_flush_ = outbox_flush_ || !async;
+    bool idle = !outbox_scheduled_;
+    outbox_scheduled_ = true;
+    return idle;
+}
 
-        // Notify of new message in queue
-        timer_.cancel_one();
+bool TCPConnection::takeOutbox(std::vector<std::shared_ptr<Message>>& messages)
+{
+    std::lock_guard lock{outbox_mutex_};
+    messages.swap(outbox_);
+    bool flush = outbox_flush_;
+    outbox_scheduled_ = false;
+    outbox_flush_ = false;
+    return flush;
+}
+
+size_t TCPConnection::gather(std::vector<asio::const_buffer>& buffers) const
+{
+    size_t bytes = 0;
+    size_t count = 0;
+    for (std::string const& message : queue_)
+    {
+        size_t offset = count == 0 ? front_offset_ : 0;
+        if (count > 0 && (count == MAX_WRITE_FRAMES || bytes + message.size() - offset > MAX_WRITE_BYTES))
+        {
+            break;
+        }
+        buffers.push_back(asio::buffer(message) + offset);
+        bytes += message.size() - offset;
+        ++count;
     }
-    catch (std::exception& e)
+    return bytes;
+}
+
+void TCPConnection::consume(size_t bytes)
+{
+    while (bytes > 0)
     {
-        std::cout << "Failed to send message. Exception " << e.what() << "\n";
+        size_t remaining = queue_.front().size() - front_offset_;
+        if (bytes < remaining)
+        {
+            front_offset_ += bytes;
+            return;
+        }
+        bytes -= remaining;
+        front_offset_ = 0;
+
+        // Keep enough ordinary buffers for a full write, letting go of any grown by an outsized message
+        std::string& sent = queue_.front();
+        if (spare_buffers_.size() < MAX_WRITE_FRAMES && sent.capacity() <= MAX_WRITE_BYTES)
+        {
+            sent.clear();
+            spare_buffers_.push_back(std::move(sent));
+        }
+        queue_.pop_front();
     }
+}
 
-    co_return;
+asio::awaitable<void> TCPConnection::read()
+{
+    // Read whatever has arrived, at least enough to complete the next message
+    size_t needed;
+    while ((needed = bytesNeeded()) > 0)
+    {
+        size_t n = co_await socket_.async_read_some(read_buffer_.prepare(needed), asio::use_awaitable);
+        read_buffer_.commit(n);
+    }
 }
 
-asio::awaitable<std::string> TCPConnection::read(std::string& read_buffer)
+bool TCPConnection::nextMessage(std::string_view& message)
 {
-    // Read until the delimiter
-    std::size_t n = co_await asio::async_read_until(socket_, asio::dynamic_buffer(read_buffer, 4096), "#END#", asio::use_awaitable);
+    if (bytesNeeded() > 0)
+    {
+        return false;
+    }
+
+    // Every message starts with a header stating its length
+    std::string_view pending = read_buffer_.data();
+    message = pending.substr(0, wireMessageLength(pending));
+    read_buffer_.consume(message.size());
+    peer_format_ = WireHeader::startsMessage(message) ? WireFormat::BINARY : WireFormat::TEXT;
 
-    // Extract the message from the buffer
-    std::string msg = read_buffer.substr(0, n);
+    return true;
+}
 
-    // Consume the message length worth of bytes from the read buffer
-    read_buffer.erase(0, n);
-    
-    co_return msg;
+size_t TCPConnection::bytesNeeded() const
+{
+    std::string_view pending = read_buffer_.data();
+    if (pending.size() < WIRE_PREFIX_SIZE)
+    {
+        return WIRE_PREFIX_SIZE - pending.size();
+    }
+    size_t length = wireMessageLength(pending);
+    return pending.size() < length ? length - pending.size() : 0;
 }
 
 bool TCPConnection::open()
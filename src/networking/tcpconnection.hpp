@@ -1,28 +1,79 @@
 #ifndef TCP_CONNECTION_HPP
 #define TCP_CONNECTION_HPP
 
-#include <queue>
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <vector>
 #include <boost/asio.hpp>
 
+#include "wireformat.hpp"
+#include "readbuffer.hpp"
+
 namespace asio = boost::asio;
 using asio::ip::tcp;
 
+class Message;
+
 class TCPConnection : std::enable_shared_from_this<TCPConnection>
 {
 public:
 
+    /** Most messages and bytes gathered into one write, though a single longer message is still sent whole. */
+    static constexpr size_t MAX_WRITE_FRAMES = 64;
+    static constexpr size_t MAX_WRITE_BYTES = 256 * 1024;
+
     TCPConnection(tcp::socket socket)
     : socket_{std::move(socket)},
       queue_{},
-      timer_{socket_.get_executor()}
+      timer_{socket_.get_executor()},
+      read_buffer_{}
     {
+        // Direct writes must return rather than block when the socket is full
+        socket_.non_blocking(true);
     }
 
     /** Queues the given message to be sent to the connected client. */
-    asio::awaitable<void> send(std::string_view message, bool async);
+    void enqueue(std::string message);
+
+    /** Queues an empty message for the caller to write into, reusing the buffer of a message already sent. */
+    std::string& enqueueBuffer();
+
+    /** Wakes the writer to send the queued messages. */
+    void notify();
+
+    /** Adds the message to the outbox from any thread. Returns true if the outbox was idle,
+     *  in which case the caller must schedule takeOutbox on the connection's strand. */
+    bool post(std::shared_ptr<Message> message, bool async);
+
+    /** Swaps the posted messages into the given empty vector, keeping both vectors' capacity.
+     *  Returns true if any of them is to be written straight away. Must be called on the connection's strand. */
+    bool takeOutbox(std::vector<std::shared_ptr<Message>>& messages);
+
+    /** Returns the vector the strand takes the outbox into. Must be called on the connection's strand. */
+    std::vector<std::shared_ptr<Message>>& sending() { return sending_; };
+
+    /** Adds the unsent part of the queued messages to the given buffers, up to the write caps. Returns the bytes added. */
+    size_t gather(std::vector<asio::const_buffer>& buffers) const;
+
+    /** Drops the given number of sent bytes from the front of the queue. */
+    void consume(size_t bytes);
 
-    /** Reads a message from the connected client. */
-    asio::awaitable<std::string> read(std::string& read_buffer);
+    /** Indicates whether the writer has a write in flight. */
+    bool writing() const { return writing_; };
+
+    /** Marks whether the writer has a write in flight. */
+    void setWriting(bool writing) { writing_ = writing; };
+
+    /** Reads from the connected client until at least one whole message is buffered. */
+    asio::awaitable<void> read();
+
+    /** Takes the next whole message from the buffer, returning false if there is none.
+     *  The message is a view of the buffer that stays valid until the next read. */
+    bool nextMessage(std::string_view& message);
+
+    /** Returns the format of the last message read, binary until the client sends one. */
+    WireFormat peerFormat() const { return peer_format_; };
 
     /** Closes the connection. */
     void close();
@@ -31,7 +82,7 @@ public:
     bool open();
 
     /** Returns the outgoing message queue for this connection. */
-    std::queue<std::string>& queue() { return queue_; };
+    std::deque<std::string>& queue() { return queue_; };
 
     /** Returns the socket associated with this connection. */
     tcp::socket& socket() { return socket_; };
@@ -42,8 +93,29 @@ public:
 private:
 
     tcp::socket socket_;
-    std::queue<std::string> queue_;
+    std::deque<std::string> queue_;
     asio::steady_timer timer_;
+    ReadBuffer read_buffer_;
+    WireFormat peer_format_ = WireFormat::BINARY;
+    bool writing_ = false;
+
+    /** Bytes of the message at the front of the queue already sent by a partial write. */
+    size_t front_offset_ = 0;
+
+    /** Buffers of sent messages, emptied and kept for the messages queued next. */
+    std::vector<std::string> spare_buffers_;
+
+    /** Messages posted from other threads and not yet serialised, guarded by the outbox mutex. */
+    std::mutex outbox_mutex_;
+    std::vector<std::shared_ptr<Message>> outbox_;
+    bool outbox_scheduled_ = false;
+    bool outbox_flush_ = false;
+
+    /** Messages taken from the outbox by the strand, serialised into the queue. */
+    std::vector<std::shared_ptr<Message>> sending_;
+
+    /** Returns the number of bytes still to be read before the buffer holds a whole message. */
+    size_t bytesNeeded() const;
 };
 
 #endif
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "tcpserver.hpp"
 #include <boost/asio.hpp>
 
+#include "../utilities/logger.hpp"
+
 namespace asio = boost::asio;
 using asio::ip::tcp;
 
@@ -20,22 +22,26 @@ asio::awaitable<void> TCPServer::messageListener(TCPConnectionPtr connection)
     unsigned int port { connection->socket().remote_endpoint().port() };
 
     try {
-        std::string read_buffer;
         while (true)
         {
-            std::string message = co_await connection->read(read_buffer);
+            co_await connection->read();
 
-            std::string response = handleMessage(address, port, message);
-            if (!response.empty())
+            // Handle every whole message that arrived before reading again
+            std::string_view message;
+            while (connection->nextMessage(message))
             {
-                co_await connection->send(response, false);
+                std::string response = handleMessage(address, port, message);
+                if (!response.empty())
+                {
+                    sendMessage(connection, std::move(response), false);
+                }
             }
         }
     }
     catch (std::exception& e)
     {
         // std::cout << "TCP message listener failed" << "\n";
-        std::cout << "Connection with " << address << ":" << port << " dropped.\n";
+        LOG_WARN << "Connection with " << address << ":" << port << " dropped.";
         // std::cout << "Reason:\n" << e.what() << "\n";
 
         removeConnection(address, port);
@@ -48,27 +54,36 @@ asio::awaitable<void> TCPServer::messageWriter(TCPConnectionPtr connection)
     unsigned int port { connection->socket().remote_endpoint().port() };
     
     try {
+        std::deque<std::string>& queue = connection->queue();
+        std::vector<asio::const_buffer> buffers;
         while (connection->open())
         {
             // Wait for new message added to queue
-            if (connection->queue().empty())
+            if (queue.empty())
             {
                 /** TODO: Decide how to handle this error code. */
                 boost::system::error_code ec;
                 co_await connection->timer().async_wait(asio::redirect_error(asio::use_awaitable, ec));
             }
-            // Send message to the connection
+            // Send the queued messages to the connection, gathered into as few writes as the caps allow
             else
             {
-                co_await asio::async_write(connection->socket(), asio::buffer(connection->queue().front()), asio::use_awaitable);
-                connection->queue().pop();
+                buffers.clear();
+                size_t bytes = connection->gather(buffers);
+
+                // Messages queued during the write are appended, leaving the ones being sent in place
+                connection->setWriting(true);
+                co_await asio::async_write(connection->socket(), buffers, asio::use_awaitable);
+                connection->setWriting(false);
+                connection->consume(bytes);
+                write_stats_.record(buffers.size(), bytes, false);
             }
         }
     }
     catch (std::exception& e)
     {
         // std::cout << "TCP message writer failed" << "\n";
-        std::cout << "Connection with " << address << ":" << port << " dropped.\n";
+        LOG_WARN << "Connection with " << address << ":" << port << " dropped.";
         // std::cout << "Reason:\n" << e.what() << "\n";
 
         removeConnection(address, port);
@@ -77,7 +92,7 @@ asio::awaitable<void> TCPServer::messageWriter(TCPConnectionPtr connection)
 
 asio::awaitable<void> TCPServer::handleAccept(tcp::socket socket)
 {
-    std::cout << "Accepted connection from " << socket.remote_endpoint() << "\n";
+    LOG_INFO << "Accepted connection from " << socket.remote_endpoint();
 
     std::string address { socket.remote_endpoint().address().to_string() };
     unsigned int port { socket.remote_endpoint().port() };
@@ -86,11 +101,11 @@ asio::awaitable<void> TCPServer::handleAccept(tcp::socket socket)
     TCPConnectionPtr connection = std::make_shared<TCPConnection>(std::move(socket));
     addConnection(address, port, connection);
 
-    // Start listening for messages from this connection
-    asio::co_spawn(io_context_, messageListener(connection), asio::detached);
+    // Start listening for messages from this connection, on the connection's strand
+    asio::co_spawn(connection->socket().get_executor(), messageListener(connection), asio::detached);
 
     // Start a writing coroutine to send messages to this connection
-    asio::co_spawn(io_context_, messageWriter(connection), asio::detached);
+    asio::co_spawn(connection->socket().get_executor(), messageWriter(connection), asio::detached);
 
     co_return;
 }
@@ -102,21 +117,65 @@ asio::awaitable<void> TCPServer::listener()
 
     while (true)
     {
-        tcp::socket socket = co_await acceptor.async_accept(asio::use_awaitable);
+        // Each connection gets a strand of its own, so its messages stay in order whichever thread serves them
+        tcp::socket socket = co_await acceptor.async_accept(asio::make_strand(io_context_), asio::use_awaitable);
         asio::co_spawn(executor, handleAccept(std::move(socket)), asio::detached);
     }
 }
 
-asio::awaitable<void> TCPServer::sendMessage(TCPConnectionPtr connection, std::string message, bool async)
+void TCPServer::sendMessage(TCPConnectionPtr connection, std::string message, bool async)
+{
+    connection->enqueue(std::move(message));
+    sendQueued(connection, async);
+}
+
+void TCPServer::sendQueued(TCPConnectionPtr connection, bool async)
+{
+    if (async)
+    {
+        connection->notify();
+    }
+    else
+    {
+        flush(connection);
+    }
+}
+
+void TCPServer::flush(TCPConnectionPtr connection)
+{
+    if (connection->writing() || connection->queue().empty() || !connection->open())
+    {
+        return;
+    }
+
+    // The socket is non-blocking, so this writes whatever fits in its send buffer and returns
+    std::vector<asio::const_buffer> buffers;
+    size_t bytes = connection->gather(buffers);
+    boost::system::error_code ec;
+    size_t written = connection->socket().write_some(buffers, ec);
+    if (written > 0)
+    {
+        connection->consume(written);
+        write_stats_.record(buffers.size(), written, true);
+    }
+
+    // Anything left, including a failed write, is up to the writer, which drops the connection on errors
+    if (written < bytes)
+    {
+        connection->notify();
+    }
+}
+
+WriteStats const& TCPServer::writeStats() const
 {
-    co_await connection->send(message, async);
+    return write_stats_;
 }
 
 asio::awaitable<void> TCPServer::connect(std::string address, const unsigned int port, std::function<void()> callback)
 {
     asio::ip::address addr = asio::ip::make_address(address);
     tcp::endpoint endpoint(addr, port);
-    tcp::socket socket(io_context_);
+    tcp::socket socket(asio::make_strand(io_context_));
 
     try
     {
@@ -129,16 +188,16 @@ asio::awaitable<void> TCPServer::connect(std::string address, const unsigned int
         // Make a callback to the caller
         callback();
         
-        // Start listening for messages from this connection
-        asio::co_spawn(io_context_, messageListener(connection), asio::detached);
+        // Start listening for messages from this connection, on the connection's strand
+        asio::co_spawn(connection->socket().get_executor(), messageListener(connection), asio::detached);
 
         // Start a writing coroutine to send messages to this connection
-        asio::co_spawn(io_context_, messageWriter(connection), asio::detached);
+        asio::co_spawn(connection->socket().get_executor(), messageWriter(connection), asio::detached);
     }
     catch (std::exception& e)
     {
-        std::cout << "Exception: " << e.what() << std::endl;
-        std::cout << "Failed to connect to " << address << ":" << port << std::endl;
+        LOG_ERROR << "Exception: " << e.what();
+        LOG_ERROR << "Failed to connect to " << address << ":" << port;
         throw e;
     }
     
@@ -3,10 +3,12 @@
 
 #include <iostream>
 #include <set>
+#include <vector>
 #include <unordered_map>
 #include <boost/asio.hpp>
 
 #include "tcpconnection.hpp"
+#include "writestats.hpp"
 
 namespace asio = boost::asio;
 using asio::ip::tcp;
@@ -30,8 +32,16 @@ public:
     /** Connects to the given address and port and adds the connection to the connections list. */
     asio::awaitable<void> connect(std::string address, const unsigned int port, std::function<void()> callback);
 
-    /** Sends a message to a given connection. */
-    asio::awaitable<void> sendMessage(TCPConnectionPtr connection, std::string message, bool async);
+    /** Sends a message to a given connection. Unless async, it is written straight away if the socket takes it
+     *  without blocking, otherwise it is left to the connection's writer. Must be called on the connection's strand. */
+    void sendMessage(TCPConnectionPtr connection, std::string message, bool async);
+
+    /** Sends the messages already queued on the given connection, gathering them into one write. Unless async,
+     *  they are written straight away if the socket takes them without blocking. Must be called on the connection's strand. */
+    void sendQueued(TCPConnectionPtr connection, bool async);
+
+    /** Returns the number of messages gathered into each write so far. */
+    WriteStats const& writeStats() const;
 
 
     /** Derived classes must implement the following: */
@@ -53,6 +63,10 @@ private:
     /** Listens for and sends outgoing messages to the given TCP connection. */
     asio::awaitable<void> messageWriter(TCPConnectionPtr connection);
 
+    /** Writes as much of the connection's queue as the socket takes without blocking, unless a write is in flight,
+     *  and wakes the writer for the rest. */
+    void flush(TCPConnectionPtr connection);
+
     /** Handles new incoming TCP connections. */
     asio::awaitable<void> handleAccept(tcp::socket socket);
 
@@ -61,6 +75,7 @@ private:
 
     const unsigned short tcp_port_;
     asio::io_context& io_context_;
+    WriteStats write_stats_;
 };
 
 #endif
\ No newline at end of file
@@ -1,7 +1,12 @@
 #include <boost/asio.hpp>
 #include <iostream>
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <arpa/inet.h>
 
 #include "udpserver.hpp"
+#include "../utilities/logger.hpp"
 
 namespace asio = boost::asio;
 using asio::ip::udp;
@@ -10,36 +15,176 @@ asio::awaitable<void> UDPServer::start()
 {
     // std::cout << "Starting a UDP server on port " << udp_port_ << "\n";
 
-    co_await listener();
+    co_await listener(socket_);
 }
 
-asio::awaitable<void> UDPServer::listener()
+asio::any_io_executor UDPServer::strand()
+{
+    return socket_.get_executor();
+}
+
+UDPServer::ReceiveBuffers::ReceiveBuffers()
+: data(MAX_RECEIVE_BATCH_SIZE * MAX_DATAGRAM_SIZE),
+  payloads(MAX_RECEIVE_BATCH_SIZE),
+  senders(MAX_RECEIVE_BATCH_SIZE),
+  headers(MAX_RECEIVE_BATCH_SIZE)
+{
+    for (size_t i = 0; i < MAX_RECEIVE_BATCH_SIZE; ++i)
+    {
+        payloads[i] = iovec{data.data() + i * MAX_DATAGRAM_SIZE, MAX_DATAGRAM_SIZE};
+        headers[i] = mmsghdr{};
+        headers[i].msg_hdr.msg_name = &senders[i];
+        headers[i].msg_hdr.msg_iov = &payloads[i];
+        headers[i].msg_hdr.msg_iovlen = 1;
+    }
+}
+
+asio::awaitable<void> UDPServer::listener(udp::socket& socket)
 {
-    auto executor = co_await asio::this_coro::executor;
     // std::cout << "Listening for UDP on port " << udp_port_ << "\n";
 
-    char data[65536];
+    ReceiveBuffers buffers;
 
     while (true)
     {
-        udp::endpoint endpoint;
-        std::size_t n = co_await socket_.async_receive_from(asio::buffer(data), endpoint, asio::use_awaitable);
-        
-        std::string message(data, n);
-        handleBroadcast(endpoint.address().to_string(), endpoint.port(), message);
+        co_await socket.async_wait(udp::socket::wait_read, asio::use_awaitable);
+        receiveBatches(socket, buffers);
     }
 }
 
-asio::awaitable<void> UDPServer::sendBroadcast(std::string_view address, const unsigned int port, std::string message)
+void UDPServer::receiveBatches(udp::socket& socket, ReceiveBuffers& buffers)
 {
-    udp::endpoint endpoint(asio::ip::make_address(address), port);
-    // std::cout << "Created an endpoint. Co-awaiting\n";
-    co_await sendBroadcast(endpoint, message);
-    // std::cout << "Broadcast was sent\n";
+    while (true)
+    {
+        // The kernel overwrites the length of each sender's address, so it is reset before every batch
+        for (mmsghdr& header : buffers.headers)
+        {
+            header.msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        }
+
+        int received = ::recvmmsg(socket.native_handle(), buffers.headers.data(), MAX_RECEIVE_BATCH_SIZE, MSG_DONTWAIT, nullptr);
+        if (received < 0)
+        {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                LOG_WARN << "Failed to receive broadcasts: " << std::strerror(errno);
+            }
+            return;
+        }
+
+        // Hand each datagram on in place, so nothing is copied before it is decoded
+        for (int i = 0; i < received; ++i)
+        {
+            mmsghdr const& header = buffers.headers[i];
+            if (header.msg_hdr.msg_flags & MSG_TRUNC)
+            {
+                LOG_WARN << "Dropped a broadcast longer than " << MAX_DATAGRAM_SIZE << " bytes";
+                continue;
+            }
+
+            char address[INET_ADDRSTRLEN];
+            ::inet_ntop(AF_INET, &buffers.senders[i].sin_addr, address, sizeof(address));
+            std::string_view message {buffers.data.data() + i * MAX_DATAGRAM_SIZE, header.msg_len};
+            handleBroadcast(address, ntohs(buffers.senders[i].sin_port), message);
+        }
+
+        // A batch that is not full means the socket has been drained
+        if (static_cast<size_t>(received) < MAX_RECEIVE_BATCH_SIZE) return;
+    }
 }
 
-asio::awaitable<void> UDPServer::sendBroadcast(udp::endpoint endpoint, std::string message)
+asio::awaitable<void> UDPServer::sendBroadcast(EndpointList endpoints, size_t start, std::string const& message)
 {
-    // std::cout << "Sending broadcast\n";
-    co_await socket_.async_send_to(asio::buffer(message), endpoint, asio::use_awaitable);
-}
\ No newline at end of file
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+    size_t count = endpoints->size();
+    size_t failed = 0;
+    size_t handled = sendBatch(*endpoints, start, message, failed);
+
+    // Wait for the socket to take the rest one at a time
+    for (size_t i = handled; i < count; ++i)
+    {
+        // A failed send must not hold back the broadcast to the remaining endpoints
+        udp::endpoint const& endpoint = (*endpoints)[(start + i) % count];
+        boost::system::error_code error;
+        co_await socket_.async_send_to(asio::buffer(message), endpoint, asio::redirect_error(asio::use_awaitable, error));
+        if (error)
+        {
+            LOG_WARN << "Broadcast to " << endpoint << " failed: " << error.message();
+            ++failed;
+        }
+    }
+
+    broadcast_stats_.record(count, count - handled, failed, std::chrono::steady_clock::now() - start_time);
+}
+
+size_t UDPServer::sendBatch(std::vector<udp::endpoint> const& endpoints, size_t start, std::string const& message, size_t& failed)
+{
+    // Every datagram carries the same payload, so they all share a single buffer
+    iovec payload {const_cast<char*>(message.data()), message.size()};
+
+    size_t handled = 0;
+    while (handled < endpoints.size())
+    {
+        size_t count = std::min(endpoints.size() - handled, MAX_BATCH_SIZE);
+        for (size_t i = 0; i < count; ++i)
+        {
+            udp::endpoint const& endpoint = endpoints[(start + handled + i) % endpoints.size()];
+            send_headers_[i] = mmsghdr{};
+            send_headers_[i].msg_hdr.msg_name = const_cast<sockaddr*>(endpoint.data());
+            send_headers_[i].msg_hdr.msg_namelen = endpoint.size();
+            send_headers_[i].msg_hdr.msg_iov = &payload;
+            send_headers_[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int sent = ::sendmmsg(socket_.native_handle(), send_headers_.data(), count, MSG_DONTWAIT);
+        if (sent > 0)
+        {
+            handled += sent;
+        }
+        else if (errno == EINTR)
+        {
+            continue;
+        }
+        else if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOSYS)
+        {
+            break;
+        }
+        else
+        {
+            // The first datagram was rejected, the rest may still go through
+            LOG_WARN << "Broadcast to " << endpoints[(start + handled) % endpoints.size()] << " failed: " << std::strerror(errno);
+            ++failed;
+            ++handled;
+        }
+    }
+
+    return handled;
+}
+
+BroadcastStats const& UDPServer::broadcastStats() const
+{
+    return broadcast_stats_;
+}
+
+void UDPServer::setMulticastInterface(asio::ip::address interface_address)
+{
+    socket_.set_option(asio::ip::multicast::outbound_interface(interface_address.to_v4()));
+}
+
+void UDPServer::joinGroup(udp::endpoint group, asio::ip::address interface_address)
+{
+    for (auto const& [joined, socket] : group_sockets_)
+    {
+        if (joined == group) return;
+    }
+
+    // Every subscriber on the host binds the group's port, so the port must be shared
+    udp::socket& socket = group_sockets_.emplace_back(group, udp::socket{strand()}).second;
+    socket.open(group.protocol());
+    socket.set_option(asio::socket_base::reuse_address(true));
+    socket.bind(udp::endpoint(group.address(), group.port()));
+    socket.set_option(asio::ip::multicast::join_group(group.address().to_v4(), interface_address.to_v4()));
+
+    asio::co_spawn(strand(), listener(socket), asio::detached);
+}
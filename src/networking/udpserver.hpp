@@ -2,43 +2,102 @@
 #define UDP_SERVER_HPP
 
 #include <iostream>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+#include <netinet/in.h>
+#include <sys/socket.h>
 #include <boost/asio.hpp>
 
+#include "broadcaststats.hpp"
+
 namespace asio = boost::asio;
 using asio::ip::udp;
 
+/** Endpoints a broadcast is sent to, shared by every broadcast to them and never modified once created. */
+typedef std::shared_ptr<const std::vector<udp::endpoint>> EndpointList;
+
 class UDPServer
 {
 public:
+
+    /** Maximum number of datagrams handed to the kernel in a single system call. */
+    static constexpr size_t MAX_BATCH_SIZE = 1024;
+
+    /** Maximum number of datagrams taken from the kernel in a single system call, and the largest received whole. */
+    static constexpr size_t MAX_RECEIVE_BATCH_SIZE = 32;
+    static constexpr size_t MAX_DATAGRAM_SIZE = 65536;
+
     UDPServer() = delete;
 
     UDPServer(asio::io_context& io_context, unsigned short port)
     : io_context_(io_context), 
       udp_port_{port},
-      socket_{io_context_, udp::endpoint(udp::v4(), port)}
+      socket_{asio::make_strand(io_context_), udp::endpoint(udp::v4(), port)},
+      send_headers_(MAX_BATCH_SIZE)
     {
     }
 
-    /** Starts the server. */
+    /** Starts the server. Must be spawned on the server's strand. */
     asio::awaitable<void> start();
 
-    /** Sends a UDP broadcast message to the given address and port destination. */
-    asio::awaitable<void> sendBroadcast(std::string_view address, const unsigned int port, std::string message);
+    /** Returns the strand the server's sockets are bound to, on which all of its sends and listeners run. */
+    asio::any_io_executor strand();
+
+    /** Sends the same UDP broadcast message to all of the given endpoints, starting from the given position and wrapping
+     *  around. The sends are batched into as few system calls as possible, falling back to one send at a time when the
+     *  socket would block. Must be awaited on the server's strand, one broadcast at a time, so each endpoint is sent
+     *  the broadcasts in order, and the message must stay unchanged until it completes. */
+    asio::awaitable<void> sendBroadcast(EndpointList endpoints, size_t start, std::string const& message);
+
+    /** Returns the timings of the batched broadcasts sent so far. */
+    BroadcastStats const& broadcastStats() const;
+
+    /** Sends multicast broadcasts through the interface with the given address. */
+    void setMulticastInterface(asio::ip::address interface_address);
 
-    /** Sends a UDP broadcast message to the given UDP endpoint. */
-    asio::awaitable<void> sendBroadcast(udp::endpoint endpoint, std::string message);
+    /** Joins the given multicast group on the interface with the given address and listens for its broadcasts. */
+    void joinGroup(udp::endpoint group, asio::ip::address interface_address);
 
-    /** Handles an incoming UDP broadcast. */
+    /** Handles an incoming UDP broadcast. The message is a view of a receive buffer, valid until the handler returns. */
     virtual void handleBroadcast(std::string_view sender_address, unsigned int sender_port, std::string_view message) = 0;
 
 private:
 
-    /** Listens for incoming UDP broadcasts. */
-    asio::awaitable<void> listener();
+    /** Buffers a listener receives a batch of datagrams into, set up once and reused for every batch. */
+    struct ReceiveBuffers
+    {
+        ReceiveBuffers();
+        ReceiveBuffers(const ReceiveBuffers&) = delete;
+        ReceiveBuffers& operator=(const ReceiveBuffers&) = delete;
+
+        std::vector<char> data;
+        std::vector<iovec> payloads;
+        std::vector<sockaddr_in> senders;
+        std::vector<mmsghdr> headers;
+    };
+
+    /** Listens for incoming UDP broadcasts on the given socket. */
+    asio::awaitable<void> listener(udp::socket& socket);
+
+    /** Takes every datagram waiting on the socket with recvmmsg, handling each in place before the buffers are reused. */
+    void receiveBatches(udp::socket& socket, ReceiveBuffers& buffers);
+
+    /** Sends the message to the given endpoints, starting from the given position and wrapping around, with sendmmsg
+     *  for as long as the socket takes them without blocking. Returns the number of endpoints handled, counting the ones that failed. */
+    size_t sendBatch(std::vector<udp::endpoint> const& endpoints, size_t start, std::string const& message, size_t& failed);
 
     const unsigned short udp_port_;
     asio::io_context& io_context_;
     udp::socket socket_;
+    BroadcastStats broadcast_stats_;
+
+    /** Headers of the datagrams handed to sendmmsg, reused for every batch. */
+    std::vector<mmsghdr> send_headers_;
+
+    /** Sockets bound to each multicast group joined, as the group's port differs from the server's. */
+    std::list<std::pair<udp::endpoint, udp::socket>> group_sockets_;
 };
 
 #endif
\ No newline at end of file
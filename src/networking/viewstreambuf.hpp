@@ -0,0 +1,20 @@
+#ifndef VIEW_STREAMBUF_HPP
+#define VIEW_STREAMBUF_HPP
+
+#include <streambuf>
+#include <string_view>
+
+/** Read-only stream buffer over bytes owned elsewhere, so that an archive can be read from them without a copy. */
+class ViewStreambuf : public std::streambuf
+{
+public:
+
+    ViewStreambuf(std::string_view bytes)
+    {
+        // The get area is only read from, so the bytes are never modified
+        char* begin = const_cast<char*>(bytes.data());
+        setg(begin, begin, begin + bytes.size());
+    }
+};
+
+#endif
@@ -0,0 +1,190 @@
+#ifndef WIRE_FORMAT_HPP
+#define WIRE_FORMAT_HPP
+
+#include <bit>
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+
+static_assert(std::endian::native == std::endian::little, "Binary messages are sent in little-endian byte order");
+
+/** The encoding of the messages sent between network entities. */
+enum class WireFormat: int {
+    TEXT,                            // Boost text archive after a short header, readable for debugging
+    BINARY                           // Fixed-layout header and body, see BinaryCodec
+};
+
+/** Returns the wire format with the given name. */
+inline WireFormat parseWireFormat(std::string_view name)
+{
+    if (name == "text") return WireFormat::TEXT;
+    if (name == "binary") return WireFormat::BINARY;
+    throw std::runtime_error("Unknown wire format " + std::string{name});
+};
+
+/** The header at the start of every binary message, followed by the body laid out for its type. */
+struct WireHeader
+{
+    /** First byte of every binary message, never the first byte of a text archive. */
+    static constexpr uint8_t MAGIC = 0xB7;
+    static constexpr uint8_t VERSION = 1;
+
+    /** Longest binary message accepted, guarding against reading a corrupt length. */
+    static constexpr uint32_t MAX_LENGTH = 16 * 1024 * 1024;
+
+    uint8_t magic;
+    uint8_t version;
+    uint16_t type;
+    uint32_t length;                 // Bytes in the message, header included
+    int32_t sender_id;
+    uint32_t reserved;
+    uint64_t timestamp_sent;
+    uint64_t timestamp_received;
+    uint64_t timestamp_processed;
+
+    /** Returns true if the given bytes start with a binary message rather than a text one. */
+    static bool startsMessage(std::string_view bytes)
+    {
+        return !bytes.empty() && static_cast<uint8_t>(bytes.front()) == MAGIC;
+    }
+};
+
+static_assert(sizeof(WireHeader) == 40, "Binary message bodies must stay 8-byte aligned");
+
+/** The header at the start of every text message, followed by its text archive. */
+struct TextHeader
+{
+    /** First byte of every text message. */
+    static constexpr uint8_t MAGIC = 0xB8;
+
+    uint8_t magic;
+    uint8_t version;
+    uint16_t reserved;
+    uint32_t length;                 // Bytes in the message, header included
+
+    /** Returns true if the given bytes start with a text message. */
+    static bool startsMessage(std::string_view bytes)
+    {
+        return !bytes.empty() && static_cast<uint8_t>(bytes.front()) == MAGIC;
+    }
+};
+
+static_assert(offsetof(WireHeader, length) == offsetof(TextHeader, length), "Both headers must state the length in the same place");
+
+/** Bytes at the start of every message, binary or text, that are enough to tell its length. */
+constexpr size_t WIRE_PREFIX_SIZE = sizeof(TextHeader);
+
+/** Returns the length of the message starting the given bytes, which must hold at least its prefix. */
+inline uint32_t wireMessageLength(std::string_view bytes)
+{
+    if (!WireHeader::startsMessage(bytes) && !TextHeader::startsMessage(bytes))
+    {
+        throw std::runtime_error("Bytes do not start with a message header");
+    }
+    uint32_t length;
+    std::memcpy(&length, bytes.data() + offsetof(TextHeader, length), sizeof(length));
+    if (length < WIRE_PREFIX_SIZE || length > WireHeader::MAX_LENGTH)
+    {
+        throw std::runtime_error("Message has an invalid length of " + std::to_string(length) + " bytes");
+    }
+    return length;
+};
+
+/** Appends the fields of a binary message to a caller-provided buffer, which keeps its capacity between messages. */
+class WireWriter
+{
+public:
+
+    WireWriter(std::string& bytes)
+    : bytes_{bytes},
+      start_{bytes.size()}
+    {
+    }
+
+    /** Appends the given record as it is laid out in memory. */
+    template <typename Record>
+    void put(Record const& record)
+    {
+        putBytes(reinterpret_cast<const char*>(&record), sizeof(Record));
+    }
+
+    /** Appends the given bytes. */
+    void putBytes(const char* data, size_t size)
+    {
+        bytes_.append(data, size);
+    }
+
+    /** Returns the bytes written so far. */
+    size_t size() const { return bytes_.size() - start_; }
+
+    /** Returns the first byte written. */
+    char* begin() const { return bytes_.data() + start_; }
+
+private:
+
+    std::string& bytes_;
+    size_t start_;
+};
+
+/** Reads the fields of a binary message from a buffer, checking that each lies within the message. */
+class WireReader
+{
+public:
+
+    WireReader(std::string_view bytes)
+    : bytes_{bytes},
+      offset_{0}
+    {
+    }
+
+    /** Reads the next record as it is laid out in memory. */
+    template <typename Record>
+    Record get()
+    {
+        Record record;
+        std::memcpy(&record, getBytes(sizeof(Record)).data(), sizeof(Record));
+        return record;
+    }
+
+    /** Reads the given number of bytes. */
+    std::string_view getBytes(size_t size)
+    {
+        if (offset_ + size > bytes_.size())
+        {
+            throw std::runtime_error("Binary message is truncated");
+        }
+        std::string_view bytes = bytes_.substr(offset_, size);
+        offset_ += size;
+        return bytes;
+    }
+
+private:
+
+    std::string_view bytes_;
+    size_t offset_;
+};
+
+/** Copies the text into a fixed-size field padded with zeros, failing if it does not fit. */
+template <size_t N>
+void copyWireText(char (&field)[N], std::string_view text)
+{
+    if (text.size() >= N)
+    {
+        throw std::runtime_error("Text " + std::string{text} + " is too long for a binary message field of " + std::to_string(N) + " bytes");
+    }
+    std::memset(field, 0, N);
+    std::memcpy(field, text.data(), text.size());
+}
+
+/** Assigns the text of a fixed-size field to the given string, reusing its storage. */
+template <size_t N>
+void readWireText(char const (&field)[N], std::string& text)
+{
+    text.assign(field, std::find(field, field + N, '\0'));
+}
+
+#endif
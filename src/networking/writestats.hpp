@@ -0,0 +1,71 @@
+#ifndef WRITE_STATS_HPP
+#define WRITE_STATS_HPP
+
+#include <atomic>
+#include <ostream>
+
+/** Counts of the messages gathered into each TCP write. Recorded by every connection's strand at once, across the IO
+ *  threads, and safe to read from any thread. */
+class WriteStats
+{
+public:
+
+    /** Records a write that gathered the given number of messages and bytes, made directly by the sender
+     *  rather than by the connection's writer. */
+    void record(size_t frames, size_t bytes, bool direct)
+    {
+        writes_.fetch_add(1, std::memory_order_relaxed);
+        if (direct)
+        {
+            direct_.fetch_add(1, std::memory_order_relaxed);
+        }
+        frames_.fetch_add(frames, std::memory_order_relaxed);
+        bytes_.fetch_add(bytes, std::memory_order_relaxed);
+
+        // Another strand may raise the maximum at the same time, so only replace the value last seen, retrying if it moved
+        size_t max_frames = max_frames_.load(std::memory_order_relaxed);
+        while (frames > max_frames && !max_frames_.compare_exchange_weak(max_frames, frames, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    /** Returns the number of writes made. */
+    size_t writes() const { return writes_.load(std::memory_order_relaxed); }
+
+    /** Returns the number of writes made directly by the sender without waking the writer. */
+    size_t direct() const { return direct_.load(std::memory_order_relaxed); }
+
+    /** Returns the number of messages sent across all writes. */
+    size_t frames() const { return frames_.load(std::memory_order_relaxed); }
+
+    /** Returns the number of bytes sent across all writes. */
+    size_t bytes() const { return bytes_.load(std::memory_order_relaxed); }
+
+    /** Returns the mean number of messages gathered into a write. */
+    double meanFrames() const
+    {
+        size_t count = writes();
+        return count == 0 ? 0.0 : static_cast<double>(frames()) / count;
+    }
+
+    /** Returns the most messages gathered into a single write. */
+    size_t maxFrames() const { return max_frames_.load(std::memory_order_relaxed); }
+
+    /** Prints the write counts. */
+    void report(std::ostream& os) const
+    {
+        os << "Writes: " << writes() << " writes of " << frames() << " messages and " << bytes()
+        << " bytes in total, " << direct() << " made directly, " << meanFrames() << " messages per write mean, "
+        << maxFrames() << " max\n";
+    }
+
+private:
+
+    std::atomic<size_t> writes_ = 0;
+    std::atomic<size_t> direct_ = 0;
+    std::atomic<size_t> frames_ = 0;
+    std::atomic<size_t> bytes_ = 0;
+    std::atomic<size_t> max_frames_ = 0;
+};
+
+#endif
@@ -2,6 +2,7 @@
 #define LIMITORDER_HPP
 
 #include "order.hpp"
+#include "price.hpp"
 
 class LimitOrder: public Order {
 public:
@@ -11,7 +12,7 @@ public:
     LimitOrder(int order_id)
     : Order(order_id, Order::Type::LIMIT) {};
 
-    int price;
+    Price price;
 
 private:
 
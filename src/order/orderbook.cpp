@@ -2,6 +2,7 @@
 
 #include "order.hpp"
 #include "orderbook.hpp"
+#include "../utilities/logger.hpp"
 
 #include <boost/serialization/export.hpp>
 
@@ -11,40 +12,66 @@ void OrderBook::addOrder(LimitOrderPtr order)
 {
     if (order->side == Order::Side::BID)
     {
-        bids_.push(order);
-        bids_volume_ += order->remaining_quantity;
-        bids_sizes_[order->price] += order->remaining_quantity;
+        bids_->push(order);
+        top_.bids_volume += order->remaining_quantity;
+        ++top_.bids_count;
+        if (top_.best_bid == TopOfBook::NO_PRICE || order->price > top_.best_bid)
+        {
+            top_.best_bid = order->price;
+            top_.best_bid_size = order->remaining_quantity;
+        }
+        else if (order->price == top_.best_bid)
+        {
+            top_.best_bid_size += order->remaining_quantity;
+        }
     }
     else
     {
-        asks_.push(order);
-        asks_volume_ += order->remaining_quantity;
-        asks_sizes_[order->price] += order->remaining_quantity;
+        asks_->push(order);
+        top_.asks_volume += order->remaining_quantity;
+        ++top_.asks_count;
+        if (top_.best_ask == TopOfBook::NO_PRICE || order->price < top_.best_ask)
+        {
+            top_.best_ask = order->price;
+            top_.best_ask_size = order->remaining_quantity;
+        }
+        else if (order->price == top_.best_ask)
+        {
+            top_.best_ask_size += order->remaining_quantity;
+        }
     }
-    ++order_count_;
+    ++version_;
+    changed_levels_.push_back({order->side, order->price});
+    recordOrderEvent({OrderEvent::Type::ADD, order->side, order->id, order->price, order->remaining_quantity});
 }
 
 std::optional<LimitOrderPtr> OrderBook::removeOrder(int order_id, Order::Side side)
 {
     if (side == Order::Side::BID)
     {
-        std::optional<LimitOrderPtr> order = bids_.remove(order_id);
+        std::optional<LimitOrderPtr> order = bids_->remove(order_id);
         if (order.has_value())
         {
-            bids_volume_ -= order.value()->remaining_quantity;
-            bids_sizes_[order.value()->price] -= order.value()->remaining_quantity;
-            --order_count_;
+            top_.bids_volume -= order.value()->remaining_quantity;
+            --top_.bids_count;
+            if (order.value()->price == top_.best_bid) refreshBest(side);
+            ++version_;
+            changed_levels_.push_back({side, order.value()->price});
+            recordOrderEvent({OrderEvent::Type::DELETE, side, order_id, order.value()->price, order.value()->remaining_quantity});
         }
         return order;
     }
     else
     {
-        std::optional<LimitOrderPtr> order = asks_.remove(order_id);
+        std::optional<LimitOrderPtr> order = asks_->remove(order_id);
         if (order.has_value())
         {
-            asks_volume_ -= order.value()->remaining_quantity;
-            asks_sizes_[order.value()->price] -= order.value()->remaining_quantity;
-            --order_count_;
+            top_.asks_volume -= order.value()->remaining_quantity;
+            --top_.asks_count;
+            if (order.value()->price == top_.best_ask) refreshBest(side);
+            ++version_;
+            changed_levels_.push_back({side, order.value()->price});
+            recordOrderEvent({OrderEvent::Type::DELETE, side, order_id, order.value()->price, order.value()->remaining_quantity});
         }
         return order;
     }
@@ -53,11 +80,12 @@ std::optional<LimitOrderPtr> OrderBook::removeOrder(int order_id, Order::Side si
 void OrderBook::updateOrderWithTrade(OrderPtr order, TradePtr trade)
     {
         // Update average price executed
-        order->avg_price = ((order->cumulative_quantity * order->avg_price) + (trade->quantity * trade->price)) / (order->cumulative_quantity + trade->quantity);
+        order->avg_price = ((order->cumulative_quantity * order->avg_price) + (trade->quantity * trade->price.toDouble())) / (order->cumulative_quantity + trade->quantity);
 
         // Update quantities
         order->cumulative_quantity += trade->quantity;
         order->remaining_quantity -= trade->quantity;
+        ++version_;
 
         // Update order status
         if (order->remaining_quantity == 0)
@@ -68,73 +96,95 @@ void OrderBook::updateOrderWithTrade(OrderPtr order, TradePtr trade)
         {
             order->setStatus(Order::Status::PARTIALLY_FILLED);
         }
+
+        // Update the resting order in place, removing it from its level once filled
+        if (order->type == Order::Type::LIMIT)
+        {
+            Price price = std::static_pointer_cast<LimitOrder>(order)->price;
+            if (order->side == Order::Side::BID && bids_->reduce(order->id, trade->quantity))
+            {
+                top_.bids_volume -= trade->quantity;
+                if (order->isFilled()) --top_.bids_count;
+                if (price == top_.best_bid) refreshBest(order->side);
+                changed_levels_.push_back({order->side, price});
+                recordOrderEvent({OrderEvent::Type::EXECUTE, order->side, order->id, price, trade->quantity});
+            }
+            else if (order->side == Order::Side::ASK && asks_->reduce(order->id, trade->quantity))
+            {
+                top_.asks_volume -= trade->quantity;
+                if (order->isFilled()) --top_.asks_count;
+                if (price == top_.best_ask) refreshBest(order->side);
+                changed_levels_.push_back({order->side, price});
+                recordOrderEvent({OrderEvent::Type::EXECUTE, order->side, order->id, price, trade->quantity});
+            }
+        }
     }
 
 std::optional<LimitOrderPtr> OrderBook::bestBid()
 {
-    if (bids_.empty())
+    if (bids_->empty())
     {
         return std::nullopt;
     }
-    return bids_.top();
+    return bids_->top();
 }
 
 int OrderBook::bestBidSize()
 {
-    std::optional<LimitOrderPtr> best_bid = bestBid();
-    if (best_bid.has_value())
-    {
-        return bids_sizes_.at(best_bid.value()->price);
-    }
-    else 
-    {
-        return 0;
-    }
+    return top_.best_bid_size;
 }
 
 std::optional<LimitOrderPtr> OrderBook::bestAsk()
 {
-    if (asks_.empty())
+    if (asks_->empty())
     {
         return std::nullopt;
     }
-    return asks_.top();
+    return asks_->top();
 }
 
 int OrderBook::bestAskSize()
 {
-    std::optional<LimitOrderPtr> best_ask = bestAsk();
-    if (best_ask.has_value())
-    {
-        return asks_sizes_.at(best_ask.value()->price);
-    }
-    else 
-    {
-        return 0;
-    }
+    return top_.best_ask_size;
+}
+
+void OrderBook::collectOrders(Order::Side side, std::vector<LimitOrderPtr>& orders) const
+{
+    side == Order::Side::BID ? bids_->collectOrders(orders) : asks_->collectOrders(orders);
+}
+
+int OrderBook::levelSize(Order::Side side, Price price) const
+{
+    return side == Order::Side::BID ? bids_->levelSize(price) : asks_->levelSize(price);
 }
 
 void OrderBook::popBestBid()
 {
-    if (!bids_.empty())
+    if (!bids_->empty())
     {
-        bids_volume_ -= bids_.top()->remaining_quantity;
-        std::cout << bids_volume_ << "\n";
-        bids_sizes_[bids_.top()->price] -= bids_.top()->remaining_quantity;
-        bids_.pop();
-        --order_count_;
+        top_.bids_volume -= bids_->top()->remaining_quantity;
+        LOG_TRACE << "Bids volume " << top_.bids_volume;
+        changed_levels_.push_back({Order::Side::BID, bids_->top()->price});
+        recordOrderEvent({OrderEvent::Type::DELETE, Order::Side::BID, bids_->top()->id, bids_->top()->price, bids_->top()->remaining_quantity});
+        bids_->pop();
+        --top_.bids_count;
+        refreshBest(Order::Side::BID);
+        ++version_;
     }
 }
 
 void OrderBook::popBestAsk()
 {
-    if (!asks_.empty())
+    if (!asks_->empty())
     {
-        asks_volume_ -= asks_.top()->remaining_quantity;
-        std::cout << asks_volume_ << "\n";
-        asks_sizes_[asks_.top()->price] -= asks_.top()->remaining_quantity;
-        asks_.pop();
-        --order_count_;
+        top_.asks_volume -= asks_->top()->remaining_quantity;
+        LOG_TRACE << "Asks volume " << top_.asks_volume;
+        changed_levels_.push_back({Order::Side::ASK, asks_->top()->price});
+        recordOrderEvent({OrderEvent::Type::DELETE, Order::Side::ASK, asks_->top()->id, asks_->top()->price, asks_->top()->remaining_quantity});
+        asks_->pop();
+        --top_.asks_count;
+        refreshBest(Order::Side::ASK);
+        ++version_;
     }
 }
 
@@ -142,45 +192,66 @@ bool OrderBook::contains(int order_id, Order::Side side)
 {
     if (side == Order::Side::BID)
     {
-        return bids_.find(order_id).has_value();
+        return bids_->find(order_id).has_value();
     }
     else
     {
-        return asks_.find(order_id).has_value();
+        return asks_->find(order_id).has_value();
     }
 }
 
-void OrderBook::logTrade(TradePtr trade)
+int OrderBook::matchableQuantity(LimitOrderPtr order)
 {
-    last_trade_ = trade;
-    trade_high_ = trade_high_.has_value() ? std::max(trade_high_.value(), trade->price) : trade->price;
-    trade_low_ = trade_low_.has_value() ? std::min(trade_low_.value(), trade->price) : trade->price;
-    trade_volume_ += trade->quantity;
-    ++trade_count_;
+    if (order->side == Order::Side::BID)
+    {
+        return asks_->availableQuantity(order->price, order->remaining_quantity);
+    }
+    else
+    {
+        return bids_->availableQuantity(order->price, order->remaining_quantity);
+    }
 }
 
-MarketDataPtr OrderBook::getLiveMarketData()
+void OrderBook::logTrade(TradePtr trade)
 {
-    MarketDataPtr data = std::make_shared<MarketData>();
-    data->ticker = ticker_;
-    data->best_bid = bestBid().has_value() ? bestBid().value()->price : -1;
-    data->best_ask = bestAsk().has_value() ? bestAsk().value()->price : -1;
-    data->best_bid_size = bestBidSize();
-    data->best_ask_size =  bestAskSize();
+    top_.last_price_traded = trade->price;
+    top_.last_quantity_traded = trade->quantity;
+    top_.high_price = top_.trades_count > 0 ? std::max(top_.high_price, trade->price) : trade->price;
+    top_.low_price = top_.trades_count > 0 ? std::min(top_.low_price, trade->price) : trade->price;
+    top_.cumulative_volume_traded += trade->quantity;
+    ++top_.trades_count;
+    ++version_;
+}
 
-    data->asks_volume = asks_volume_;
-    data->bids_volume = bids_volume_;
-    data->asks_count = asks_.size();
-    data->bids_count = bids_.size();
+bool OrderBook::isValidPrice(Price price)
+{
+    return bids_->acceptsPrice(price) && asks_->acceptsPrice(price);
+}
 
-    data->last_price_traded = last_trade_.has_value() ? last_trade_.value()->price : -1;
-    data->last_quantity_traded = last_trade_.has_value() ? last_trade_.value()->quantity : 0;
+MarketDataPtr OrderBook::getLiveMarketData(unsigned long long timestamp, ObjectPool<MarketData>* pool)
+{
+    MarketDataPtr data = pool ? pool->create() : std::make_shared<MarketData>();
+    data->ticker = ticker_;
+    static_cast<TopOfBook&>(*data) = top_;
+    data->timestamp = timestamp;
+    return data;
+}
 
-    data->high_price = trade_high_.has_value() ? trade_high_.value() : -1;
-    data->low_price = trade_low_.has_value() ? trade_low_.value() : -1;
-    data->cumulative_volume_traded = trade_volume_;
-    data->trades_count = trade_count_;
+MarketDataPtr OrderBook::getLiveMarketData()
+{
+    return getLiveMarketData(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+}
 
-    data->timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
-    return data;
-}
\ No newline at end of file
+void OrderBook::refreshBest(Order::Side side)
+{
+    if (side == Order::Side::BID)
+    {
+        top_.best_bid = bids_->empty() ? TopOfBook::NO_PRICE : bids_->top()->price;
+        top_.best_bid_size = bids_->topSize();
+    }
+    else
+    {
+        top_.best_ask = asks_->empty() ? TopOfBook::NO_PRICE : asks_->top()->price;
+        top_.best_ask_size = asks_->topSize();
+    }
+}
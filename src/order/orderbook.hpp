@@ -4,8 +4,7 @@
 #include <iostream>
 #include <string>
 #include <chrono>
-#include <queue>
-#include <unordered_map>
+#include <vector>
 
 #include <boost/archive/text_oarchive.hpp>
 #include <boost/archive/text_iarchive.hpp>
@@ -14,8 +13,12 @@
 #include "order.hpp"
 #include "limitorder.hpp"
 #include "orderqueue.hpp"
+#include "pricelevelqueue.hpp"
+#include "tickladderqueue.hpp"
+#include "../config/tickerconfig.hpp"
 #include "../trade/trade.hpp"
 #include "../trade/marketdata.hpp"
+#include "../trade/orderevent.hpp"
 
 class OrderBook;
 typedef std::shared_ptr<OrderBook> OrderBookPtr;
@@ -25,14 +28,15 @@ class OrderBook : std::enable_shared_from_this<OrderBook> {
 public:
 
     OrderBook(std::string_view ticker)
-    : ticker_{std::string(ticker)},
-      bids_{Order::Side::BID},
-      asks_{Order::Side::ASK},
-      bids_volume_{0},
-      asks_volume_{0},
-      order_count_{0},
-      trade_volume_{0},
-      trade_count_{0}
+    : OrderBook(TickerConfig{ticker})
+    {
+    }
+
+    OrderBook(TickerConfig const& config)
+    : ticker_{config.ticker},
+      bids_{createQueue(config, Order::Side::BID)},
+      asks_{createQueue(config, Order::Side::ASK)},
+      top_{}
     {
     }
     
@@ -42,7 +46,7 @@ public:
     /** Removes the given order from the order book if exists. Returns nullopt if order does not exist. */
     std::optional<LimitOrderPtr> removeOrder(int order_id, Order::Side side);
 
-    /** Updates the order quantity and price based on the executed trade. */
+    /** Updates the order quantity and price based on the executed trade. Resting orders are updated in place. */
     void updateOrderWithTrade(OrderPtr order, TradePtr trade);
 
     /** Returns the best bid in the order book. */
@@ -66,10 +70,67 @@ public:
     /** Checks if the given order exists in the order book. */
     bool contains(int order_id, Order::Side side);
 
+    /** Returns the quantity of the given order that could be matched immediately against the opposite side. */
+    int matchableQuantity(LimitOrderPtr order);
+
     /** Logs the details of the executed trade for statistics. */
     void logTrade(TradePtr trade);
 
-    /** Returns live level 1 market data. */
+    /** Checks if an order at the given price can rest in the order book. */
+    bool isValidPrice(Price price);
+
+    /** Returns a counter incremented on every change to the orders or trade statistics of the book. */
+    unsigned long long version() const
+    {
+        return version_;
+    }
+
+    /** Returns the aggregate size of all orders at the given price on the given side. */
+    int levelSize(Order::Side side, Price price) const;
+
+    /** Returns the price levels changed since the changes were last cleared, possibly more than once. */
+    std::vector<std::pair<Order::Side, Price>> const& changedLevels() const
+    {
+        return changed_levels_;
+    }
+
+    /** Forgets the changed price levels once they have been published. */
+    void clearChangedLevels()
+    {
+        changed_levels_.clear();
+    }
+
+    /** Appends the resting orders on the given side to the given vector in priority order. */
+    void collectOrders(Order::Side side, std::vector<LimitOrderPtr>& orders) const;
+
+    /** Returns the number of order events recorded so far, i.e. the sequence number of the latest one. */
+    unsigned long long orderEventSequence() const
+    {
+        return order_event_sequence_;
+    }
+
+    /** Returns the changes to individual resting orders since the events were last cleared. */
+    std::vector<OrderEvent> const& orderEvents() const
+    {
+        return order_events_;
+    }
+
+    /** Forgets the order events once they have been published. */
+    void clearOrderEvents()
+    {
+        order_events_.clear();
+    }
+
+    /** Returns the level 1 statistics of the book. */
+    TopOfBook const& topOfBook() const
+    {
+        return top_;
+    }
+
+    /** Returns live level 1 market data stamped with the given time, drawn from the given pool if any. */
+    MarketDataPtr getLiveMarketData(unsigned long long timestamp, ObjectPool<MarketData>* pool = nullptr);
+
+    /** Returns live level 1 market data stamped with the current time. */
     MarketDataPtr getLiveMarketData();
 
     /** Creates a new order book for the given ticker. */
@@ -78,25 +139,49 @@ public:
         return std::make_shared<OrderBook>(ticker);
     }
 
+    /** Creates a new order book with the backend selected in the given ticker config. */
+    static OrderBookPtr create(TickerConfig const& config)
+    {
+        return std::make_shared<OrderBook>(config);
+    }
+
 private:
 
+    /** Updates the best price and size of the given side after a change at its best level. */
+    void refreshBest(Order::Side side);
+
+    /** Records a change to a resting order for the market by order feed. */
+    void recordOrderEvent(OrderEvent const& event)
+    {
+        order_events_.push_back(event);
+        ++order_event_sequence_;
+    }
+
+    /** Creates the order queue for one side of the book. */
+    static OrderQueuePtr createQueue(TickerConfig const& config, Order::Side side)
+    {
+        if (config.book_type == TickerConfig::BookType::TICK_LADDER)
+        {
+            return std::make_shared<TickLadderQueue>(side, config.tick_size, config.min_price, config.max_price);
+        }
+        return std::make_shared<PriceLevelQueue>(side, config.tick_size);
+    }
+
     std::string ticker_;
-    OrderQueue bids_;
-    OrderQueue asks_;
+    OrderQueuePtr bids_;
+    OrderQueuePtr asks_;
 
-    int bids_volume_;
-    int asks_volume_;
-    int order_count_;
+    /** Level 1 statistics, updated along with the queues. */
+    TopOfBook top_;
 
-    std::unordered_map<double, int> bids_sizes_;
-    std::unordered_map<double, int> asks_sizes_;
+    unsigned long long version_ = 0;
 
-    std::optional<TradePtr> last_trade_;
+    /** Price levels changed since last cleared, for publishing level 2 updates. */
+    std::vector<std::pair<Order::Side, Price>> changed_levels_;
 
-    std::optional<double> trade_high_;
-    std::optional<double> trade_low_;
-    int trade_volume_;
-    int trade_count_;
+    /** Changes to resting orders since last cleared, for publishing market by order updates. */
+    std::vector<OrderEvent> order_events_;
+    unsigned long long order_event_sequence_ = 0;
 };
 
 #endif
\ No newline at end of file
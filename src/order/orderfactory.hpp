@@ -5,6 +5,7 @@
 #include "marketorder.hpp"
 #include "../message/limit_order_message.hpp"
 #include "../message/market_order_message.hpp"
+#include "../utilities/memorypool.hpp"
 
 class OrderFactory
 {
@@ -12,9 +13,19 @@ public:
 
     OrderFactory() = default;
 
+    /** Creates a factory drawing orders from the given pools instead of the heap.
+     *  Ids are offset and strided so that several factories can share one id space. */
+    OrderFactory(ObjectPool<LimitOrder>* limit_order_pool, ObjectPool<MarketOrder>* market_order_pool, int id_offset = 0, int id_stride = 1)
+    : limit_order_pool_{limit_order_pool},
+      market_order_pool_{market_order_pool},
+      id_offset_{id_offset},
+      id_stride_{id_stride}
+    {
+    }
+
     LimitOrderPtr createLimitOrder(LimitOrderMessagePtr msg)
     {
-        LimitOrderPtr order = std::make_shared<LimitOrder>(++order_id_);
+        LimitOrderPtr order = limit_order_pool_ ? limit_order_pool_->create(nextOrderId()) : std::make_shared<LimitOrder>(nextOrderId());
         order->sender_id = msg->sender_id;
         order->client_order_id = msg->client_order_id;
         order->priv_value = msg->priv_value;
@@ -33,7 +44,7 @@ public:
 
     MarketOrderPtr createMarketOrder(MarketOrderMessagePtr msg)
     {
-        MarketOrderPtr order = std::make_shared<MarketOrder>(++order_id_);
+        MarketOrderPtr order = market_order_pool_ ? market_order_pool_->create(nextOrderId()) : std::make_shared<MarketOrder>(nextOrderId());
         order->sender_id = msg->sender_id;
         order->client_order_id = msg->client_order_id;
         order->priv_value = msg->priv_value;
@@ -55,7 +66,16 @@ public:
 
 private:
 
+    int nextOrderId()
+    {
+        return (order_id_++) * id_stride_ + id_offset_ + 1;
+    }
+
     int order_id_ = 0;
+    ObjectPool<LimitOrder>* limit_order_pool_ = nullptr;
+    ObjectPool<MarketOrder>* market_order_pool_ = nullptr;
+    int id_offset_ = 0;
+    int id_stride_ = 1;
 };
 
 #endif
\ No newline at end of file
@@ -1,51 +1,78 @@
 #ifndef ORDER_QUEUE_HPP
 #define ORDER_QUEUE_HPP
 
-#include <queue>
+#include <list>
+#include <vector>
+#include <memory>
 #include <optional>
-#include <functional>
 
 #include "limitorder.hpp"
+#include "price.hpp"
+#include "../utilities/memorypool.hpp"
 
-/** A FIFO queue with price-time priority for currently active orders. */
-class OrderQueue: public std::priority_queue<LimitOrderPtr, std::vector<LimitOrderPtr>, std::function<bool(LimitOrderPtr, LimitOrderPtr)>> {
-public:
+/** A single price level holding the resting orders at that price in FIFO (time priority) order. */
+struct PriceLevel
+{
+    typedef std::list<LimitOrderPtr, PoolAllocator<LimitOrderPtr>> OrderList;
 
-    OrderQueue(Order::Side side)
-    : std::priority_queue<LimitOrderPtr, std::vector<LimitOrderPtr>, std::function<bool(LimitOrderPtr, LimitOrderPtr)>>()
+    PriceLevel(Price price, PoolAllocator<LimitOrderPtr> allocator)
+    : price{price},
+      orders{allocator}
     {
-        if (side == Order::Side::BID) 
-        {
-            // Sort bids in descending order
-            this->comp = [](LimitOrderPtr a, LimitOrderPtr b) { 
-                if (a->price != b->price) {
-                    return a->price <= b->price; 
-                }
-                else {
-                    // Compare timestamps if prices are equal
-                    return a->timestamp_created <= b->timestamp_created;
-                }
-            };
-        } else {
-            // Sort asks in ascending order
-            this->comp = [](LimitOrderPtr a, LimitOrderPtr b) { 
-                if (a->price != b->price) {
-                    return a->price >= b->price; 
-                }
-                else {
-                    // Compare timestamps if prices are equal
-                    return a->timestamp_created <= b->timestamp_created;
-                }
-             };
-        }
     }
 
+    Price price;
+    int size = 0;
+    OrderList orders;
+};
+
+/** One side of the order book with price-time priority for currently active orders. */
+class OrderQueue {
+public:
+
+    virtual ~OrderQueue() = default;
+
+    /** Adds the given order to the back of its price level. */
+    virtual void push(LimitOrderPtr order) = 0;
+
+    /** Returns the order with the highest priority. The queue must not be empty. */
+    virtual LimitOrderPtr top() const = 0;
+
+    /** Removes the order with the highest priority. */
+    virtual void pop() = 0;
+
+    /** Returns the aggregate size of all orders at the best price level. */
+    virtual int topSize() const = 0;
+
+    /** Returns true if there are no orders in the queue. */
+    virtual bool empty() const = 0;
+
+    /** Returns the number of orders in the queue. */
+    virtual size_t size() const = 0;
+
     /** Finds and returns the order with the given id if present in the queue. */
-    std::optional<LimitOrderPtr> find(int order_id);
+    virtual std::optional<LimitOrderPtr> find(int order_id) const = 0;
 
     /** Removes and returns the order with the given id if present in the queue. */
-    std::optional<LimitOrderPtr> remove(int order_id);
+    virtual std::optional<LimitOrderPtr> remove(int order_id) = 0;
+
+    /** Reduces the size of the given order's price level after a fill of the given quantity.
+     *  Removes the order once fully filled. Returns false if the order is not in the queue. */
+    virtual bool reduce(int order_id, int quantity) = 0;
 
+    /** Returns the quantity resting at prices at or better than the given limit price, up to the given quantity. */
+    virtual int availableQuantity(Price limit_price, int quantity) const = 0;
+
+    /** Returns the aggregate size of all orders at the given price, 0 if there are none. */
+    virtual int levelSize(Price price) const = 0;
+
+    /** Appends all orders in the queue to the given vector in priority order. */
+    virtual void collectOrders(std::vector<LimitOrderPtr>& orders) const = 0;
+
+    /** Returns true if an order at the given price can rest in this queue. */
+    virtual bool acceptsPrice(Price price) const = 0;
 };
 
-#endif
\ No newline at end of file
+typedef std::shared_ptr<OrderQueue> OrderQueuePtr;
+
+#endif
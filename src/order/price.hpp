@@ -0,0 +1,126 @@
+#ifndef PRICE_HPP
+#define PRICE_HPP
+
+#include <cmath>
+#include <string>
+#include <compare>
+#include <charconv>
+#include <iostream>
+#include <functional>
+
+#include <boost/serialization/serialization.hpp>
+#include <boost/serialization/level.hpp>
+#include <boost/serialization/tracking.hpp>
+
+/** A fixed-point price stored as a whole number of price units.
+ *  Comparison, hashing and arithmetic on prices are plain integer operations. */
+class Price
+{
+public:
+
+    typedef long long Units;
+
+    /** The number of price units in one currency unit, i.e. prices have four decimal places. */
+    static constexpr Units SCALE = 10000;
+
+    constexpr Price() = default;
+
+    /** Creates a price from a whole number of price units. */
+    static constexpr Price fromUnits(Units units)
+    {
+        Price price;
+        price.units_ = units;
+        return price;
+    }
+
+    /** Creates a price from a decimal value, rounded to the nearest price unit. */
+    static Price fromDouble(double value)
+    {
+        return fromUnits(std::llround(value * SCALE));
+    }
+
+    /** Returns the price as a whole number of price units. */
+    constexpr Units units() const { return units_; }
+
+    /** Returns the price as a decimal value. */
+    double toDouble() const { return static_cast<double>(units_) / SCALE; }
+
+    /** Returns the number of whole ticks of the given size in the price. */
+    constexpr Units ticks(Price tick_size) const { return units_ / tick_size.units_; }
+
+    /** Checks if the price lies on the grid of the given tick size. */
+    constexpr bool isMultipleOf(Price tick_size) const { return units_ % tick_size.units_ == 0; }
+
+    constexpr Price operator-() const { return fromUnits(-units_); }
+    constexpr Price operator+(Price other) const { return fromUnits(units_ + other.units_); }
+    constexpr Price operator-(Price other) const { return fromUnits(units_ - other.units_); }
+    constexpr Price operator*(Units n) const { return fromUnits(units_ * n); }
+
+    constexpr auto operator<=>(Price const& other) const = default;
+
+    /** Writes the price as a decimal without trailing zeros to the given buffer of at least 32 chars.
+     *  Returns the end of the written characters. */
+    char* format(char* out) const
+    {
+        Units whole = units_ / SCALE;
+        Units fraction = units_ % SCALE;
+        if (units_ < 0)
+        {
+            *out++ = '-';
+            whole = -whole;
+            fraction = -fraction;
+        }
+
+        out = std::to_chars(out, out + 24, whole).ptr;
+        if (fraction != 0)
+        {
+            *out++ = '.';
+            for (Units digit = SCALE / 10; fraction != 0; digit /= 10)
+            {
+                *out++ = static_cast<char>('0' + fraction / digit);
+                fraction %= digit;
+            }
+        }
+        return out;
+    }
+
+    /** Returns the price as a decimal string without trailing zeros. */
+    std::string toString() const
+    {
+        char buffer[32];
+        return std::string(buffer, format(buffer));
+    }
+
+private:
+
+    Units units_ = 0;
+
+    friend std::ostream& operator<<(std::ostream& os, const Price& price)
+    {
+        char buffer[32];
+        os.write(buffer, price.format(buffer) - buffer);
+        return os;
+    }
+
+    friend class boost::serialization::access;
+    template<class Archive>
+    void serialize(Archive & ar, const unsigned int version)
+    {
+        ar & units_;
+    }
+};
+
+// Serialise prices as a bare integer without class information
+BOOST_CLASS_IMPLEMENTATION(Price, boost::serialization::object_serializable);
+BOOST_CLASS_TRACKING(Price, boost::serialization::track_never);
+
+template<>
+struct std::hash<Price>
+{
+    size_t operator()(Price const& price) const noexcept
+    {
+        return std::hash<Price::Units>{}(price.units());
+    }
+};
+
+#endif
@@ -0,0 +1,123 @@
+#include <algorithm>
+
+#include "pricelevelqueue.hpp"
+
+void PriceLevelQueue::push(LimitOrderPtr order)
+{
+    LevelMap::iterator level = levels_.try_emplace(keyFor(order->price), order->price, PoolAllocator<LimitOrderPtr>{&order_pool_}).first;
+    level->second.size += order->remaining_quantity;
+    level->second.orders.push_back(order);
+
+    index_.insert({order->id, OrderHandle{level, std::prev(level->second.orders.end())}});
+};
+
+LimitOrderPtr PriceLevelQueue::top() const
+{
+    return levels_.begin()->second.orders.front();
+};
+
+void PriceLevelQueue::pop()
+{
+    if (!levels_.empty())
+    {
+        remove(top()->id);
+    }
+};
+
+int PriceLevelQueue::topSize() const
+{
+    return levels_.empty() ? 0 : levels_.begin()->second.size;
+};
+
+bool PriceLevelQueue::empty() const
+{
+    return levels_.empty();
+};
+
+size_t PriceLevelQueue::size() const
+{
+    return index_.size();
+};
+
+std::optional<LimitOrderPtr> PriceLevelQueue::find(int order_id) const
+{
+    auto it = index_.find(order_id);
+    if (it == index_.end())
+    {
+        return std::nullopt;
+    }
+    return *(it->second.position);
+};
+
+std::optional<LimitOrderPtr> PriceLevelQueue::remove(int order_id)
+{
+    auto it = index_.find(order_id);
+    if (it == index_.end())
+    {
+        return std::nullopt;
+    }
+
+    LimitOrderPtr order = *(it->second.position);
+    it->second.level->second.size -= order->remaining_quantity;
+    erase(it->second);
+    index_.erase(it);
+
+    return order;
+};
+
+bool PriceLevelQueue::reduce(int order_id, int quantity)
+{
+    auto it = index_.find(order_id);
+    if (it == index_.end())
+    {
+        return false;
+    }
+
+    it->second.level->second.size -= quantity;
+
+    // Fully filled orders leave the queue, partially filled orders keep their time priority
+    if ((*it->second.position)->isFilled())
+    {
+        erase(it->second);
+        index_.erase(it);
+    }
+    return true;
+};
+
+int PriceLevelQueue::availableQuantity(Price limit_price, int quantity) const
+{
+    int available = 0;
+    for (auto it = levels_.begin(); it != levels_.end() && it->first <= keyFor(limit_price) && available < quantity; ++it)
+    {
+        available += it->second.size;
+    }
+    return std::min(available, quantity);
+};
+
+void PriceLevelQueue::erase(OrderHandle handle)
+{
+    handle.level->second.orders.erase(handle.position);
+    if (handle.level->second.orders.empty())
+    {
+        levels_.erase(handle.level);
+    }
+};
+
+int PriceLevelQueue::levelSize(Price price) const
+{
+    auto it = levels_.find(keyFor(price));
+    return it == levels_.end() ? 0 : it->second.size;
+};
+
+void PriceLevelQueue::collectOrders(std::vector<LimitOrderPtr>& orders) const
+{
+    for (auto const& [key, level] : levels_)
+    {
+        orders.insert(orders.end(), level.orders.begin(), level.orders.end());
+    }
+};
+
+bool PriceLevelQueue::acceptsPrice(Price price) const
+{
+    return price.isMultipleOf(tick_size_);
+};
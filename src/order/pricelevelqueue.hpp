@@ -0,0 +1,86 @@
+#ifndef PRICE_LEVEL_QUEUE_HPP
+#define PRICE_LEVEL_QUEUE_HPP
+
+#include <map>
+#include <unordered_map>
+
+#include "orderqueue.hpp"
+
+/** Order queue keeping per-price FIFO levels in a sorted map, with orders indexed by id.
+ *  Suitable for instruments with an unbounded price range. Prices must lie on the tick grid. */
+class PriceLevelQueue : public OrderQueue {
+public:
+
+    PriceLevelQueue(Order::Side side, Price tick_size)
+    : side_{side},
+      tick_size_{tick_size},
+      level_pool_{"price levels", 256},
+      order_pool_{"resting orders", 4096},
+      index_pool_{"order index", 4096},
+      levels_{LevelMap::allocator_type{&level_pool_}},
+      index_{0, std::hash<int>{}, std::equal_to<int>{}, OrderIndex::allocator_type{&index_pool_}}
+    {
+    }
+
+    void push(LimitOrderPtr order) override;
+
+    LimitOrderPtr top() const override;
+
+    void pop() override;
+
+    int topSize() const override;
+
+    bool empty() const override;
+
+    size_t size() const override;
+
+    std::optional<LimitOrderPtr> find(int order_id) const override;
+
+    std::optional<LimitOrderPtr> remove(int order_id) override;
+
+    bool reduce(int order_id, int quantity) override;
+
+    int availableQuantity(Price limit_price, int quantity) const override;
+
+    int levelSize(Price price) const override;
+
+    void collectOrders(std::vector<LimitOrderPtr>& orders) const override;
+
+    bool acceptsPrice(Price price) const override;
+
+private:
+
+    /** Levels are keyed so that the best price always sorts first: negated for bids, as is for asks. */
+    typedef std::map<Price, PriceLevel, std::less<Price>, PoolAllocator<std::pair<const Price, PriceLevel>>> LevelMap;
+
+    /** The location of a resting order within the queue. */
+    struct OrderHandle
+    {
+        LevelMap::iterator level;
+        PriceLevel::OrderList::iterator position;
+    };
+
+    typedef std::unordered_map<int, OrderHandle, std::hash<int>, std::equal_to<int>, PoolAllocator<std::pair<const int, OrderHandle>>> OrderIndex;
+
+    /** Returns the level key for the given price. */
+    Price keyFor(Price price) const
+    {
+        return side_ == Order::Side::BID ? -price : price;
+    }
+
+    /** Unlinks the order at the given handle and drops its level if it became empty. */
+    void erase(OrderHandle handle);
+
+    Order::Side side_;
+    Price tick_size_;
+
+    /** Node pools recycling the map, list and index nodes, declared first to outlive the containers. */
+    MemoryPool level_pool_;
+    MemoryPool order_pool_;
+    MemoryPool index_pool_;
+
+    LevelMap levels_;
+    OrderIndex index_;
+};
+
+#endif
@@ -0,0 +1,128 @@
+#include <algorithm>
+
+#include "tickladderqueue.hpp"
+
+void TickLadderQueue::push(LimitOrderPtr order)
+{
+    size_t level = (order->price - min_price_).ticks(tick_size_);
+    levels_[level].size += order->remaining_quantity;
+    levels_[level].orders.push_back(order);
+    occupied_.set(level);
+
+    index_.insert({order->id, OrderHandle{level, std::prev(levels_[level].orders.end())}});
+};
+
+LimitOrderPtr TickLadderQueue::top() const
+{
+    return levels_[bestLevel()].orders.front();
+};
+
+void TickLadderQueue::pop()
+{
+    if (!occupied_.empty())
+    {
+        remove(top()->id);
+    }
+};
+
+int TickLadderQueue::topSize() const
+{
+    return occupied_.empty() ? 0 : levels_[bestLevel()].size;
+};
+
+bool TickLadderQueue::empty() const
+{
+    return occupied_.empty();
+};
+
+size_t TickLadderQueue::size() const
+{
+    return index_.size();
+};
+
+std::optional<LimitOrderPtr> TickLadderQueue::find(int order_id) const
+{
+    auto it = index_.find(order_id);
+    if (it == index_.end())
+    {
+        return std::nullopt;
+    }
+    return *(it->second.position);
+};
+
+std::optional<LimitOrderPtr> TickLadderQueue::remove(int order_id)
+{
+    auto it = index_.find(order_id);
+    if (it == index_.end())
+    {
+        return std::nullopt;
+    }
+
+    LimitOrderPtr order = *(it->second.position);
+    levels_[it->second.level].size -= order->remaining_quantity;
+    erase(it->second);
+    index_.erase(it);
+
+    return order;
+};
+
+bool TickLadderQueue::reduce(int order_id, int quantity)
+{
+    auto it = index_.find(order_id);
+    if (it == index_.end())
+    {
+        return false;
+    }
+
+    levels_[it->second.level].size -= quantity;
+
+    // Fully filled orders leave the ladder, partially filled orders keep their time priority
+    if ((*it->second.position)->isFilled())
+    {
+        erase(it->second);
+        index_.erase(it);
+    }
+    return true;
+};
+
+int TickLadderQueue::availableQuantity(Price limit_price, int quantity) const
+{
+    int available = 0;
+    for (size_t level = bestLevel(); level != OccupancyBitmap::npos && available < quantity; level = nextLevel(level))
+    {
+        Price price = levels_[level].price;
+        if (side_ == Order::Side::BID ? price < limit_price : price > limit_price) break;
+
+        available += levels_[level].size;
+    }
+    return std::min(available, quantity);
+};
+
+int TickLadderQueue::levelSize(Price price) const
+{
+    if (!acceptsPrice(price)) return 0;
+    size_t level = (price - min_price_).ticks(tick_size_);
+    return occupied_.test(level) ? levels_[level].size : 0;
+};
+
+void TickLadderQueue::collectOrders(std::vector<LimitOrderPtr>& orders) const
+{
+    for (size_t level = bestLevel(); level != OccupancyBitmap::npos; level = nextLevel(level))
+    {
+        orders.insert(orders.end(), levels_[level].orders.begin(), levels_[level].orders.end());
+    }
+};
+
+bool TickLadderQueue::acceptsPrice(Price price) const
+{
+    return price >= min_price_ && price <= max_price_ && (price - min_price_).isMultipleOf(tick_size_);
+};
+
+void TickLadderQueue::erase(OrderHandle handle)
+{
+    levels_[handle.level].orders.erase(handle.position);
+    if (levels_[handle.level].orders.empty())
+    {
+        occupied_.reset(handle.level);
+    }
+};
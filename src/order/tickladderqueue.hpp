@@ -0,0 +1,120 @@
+#ifndef TICK_LADDER_QUEUE_HPP
+#define TICK_LADDER_QUEUE_HPP
+
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "orderqueue.hpp"
+#include "../utilities/occupancybitmap.hpp"
+
+/** Order queue for instruments with a bounded price band, keeping one FIFO level per tick
+ *  in a contiguous array and tracking non-empty levels with a hierarchical bitmap. */
+class TickLadderQueue : public OrderQueue {
+public:
+
+    /** Largest number of ticks in the price band, bounding the levels allocated upfront per side. */
+    static constexpr long long MAX_LEVELS = 1 << 20;
+
+    TickLadderQueue(Order::Side side, Price tick_size, Price min_price, Price max_price)
+    : side_{side},
+      tick_size_{tick_size},
+      min_price_{min_price},
+      max_price_{max_price},
+      order_pool_{"resting orders", 4096},
+      index_pool_{"order index", 4096},
+      levels_{},
+      occupied_{levelCount(tick_size, min_price, max_price)},
+      index_{0, std::hash<int>{}, std::equal_to<int>{}, OrderIndex::allocator_type{&index_pool_}}
+    {
+        size_t level_count = levelCount(tick_size, min_price, max_price);
+        levels_.reserve(level_count);
+        for (size_t i = 0; i < level_count; ++i)
+        {
+            levels_.emplace_back(min_price + tick_size * i, PoolAllocator<LimitOrderPtr>{&order_pool_});
+        }
+    }
+
+    void push(LimitOrderPtr order) override;
+
+    LimitOrderPtr top() const override;
+
+    void pop() override;
+
+    int topSize() const override;
+
+    bool empty() const override;
+
+    size_t size() const override;
+
+    std::optional<LimitOrderPtr> find(int order_id) const override;
+
+    std::optional<LimitOrderPtr> remove(int order_id) override;
+
+    bool reduce(int order_id, int quantity) override;
+
+    int availableQuantity(Price limit_price, int quantity) const override;
+
+    int levelSize(Price price) const override;
+
+    void collectOrders(std::vector<LimitOrderPtr>& orders) const override;
+
+    bool acceptsPrice(Price price) const override;
+
+    /** Returns the number of levels spanning the price band, throwing if it exceeds MAX_LEVELS. */
+    static size_t levelCount(Price tick_size, Price min_price, Price max_price)
+    {
+        long long level_count = (max_price - min_price).ticks(tick_size) + 1;
+        if (level_count > MAX_LEVELS)
+        {
+            throw std::runtime_error("Price band of " + std::to_string(level_count) + " ticks exceeds the ladder maximum of " + std::to_string(MAX_LEVELS));
+        }
+        return static_cast<size_t>(level_count);
+    }
+
+private:
+
+    /** The location of a resting order within the ladder. */
+    struct OrderHandle
+    {
+        size_t level;
+        PriceLevel::OrderList::iterator position;
+    };
+
+    typedef std::unordered_map<int, OrderHandle, std::hash<int>, std::equal_to<int>, PoolAllocator<std::pair<const int, OrderHandle>>> OrderIndex;
+
+    /** Returns the index of the best occupied level or npos if the queue is empty. */
+    size_t bestLevel() const
+    {
+        return side_ == Order::Side::BID ? occupied_.last() : occupied_.first();
+    }
+
+    /** Returns the index of the next occupied level with a worse price than the given one, or npos. */
+    size_t nextLevel(size_t level) const
+    {
+        if (side_ == Order::Side::BID)
+        {
+            return level == 0 ? OccupancyBitmap::npos : occupied_.prev(level - 1);
+        }
+        return occupied_.next(level + 1);
+    }
+
+    /** Unlinks the order at the given handle and marks its level empty if no orders remain. */
+    void erase(OrderHandle handle);
+
+    Order::Side side_;
+    Price tick_size_;
+    Price min_price_;
+    Price max_price_;
+
+    /** Node pools recycling the list and index nodes, declared first to outlive the containers. */
+    MemoryPool order_pool_;
+    MemoryPool index_pool_;
+
+    std::vector<PriceLevel> levels_;
+    OccupancyBitmap occupied_;
+    OrderIndex index_;
+};
+
+#endif
@@ -0,0 +1,207 @@
+#ifndef TAPE_FORMAT_HPP
+#define TAPE_FORMAT_HPP
+
+#include <bit>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#include "../order/price.hpp"
+
+static_assert(std::endian::native == std::endian::little, "Binary tapes are written in little-endian byte order");
+
+/** The file format of the trade tapes, market data feeds and message tapes written by an exchange. */
+enum class TapeFormat
+{
+    CSV,
+    BINARY
+};
+
+/** The type of a field of a binary tape record. */
+enum class TapeFieldType : uint8_t
+{
+    INT32,
+    UINT64,
+    FLOAT64,
+    PRICE,                      // Signed 64-bit count of 1 / price_scale units
+    TEXT                        // Zero padded characters
+};
+
+/** Describes a field of the records in a binary tape. */
+struct TapeField
+{
+    char name[32];
+    TapeFieldType type;
+    uint8_t reserved;
+    uint16_t size;
+    uint16_t offset;
+    uint16_t padding;
+};
+
+/** The header at the start of a binary tape, followed by a field description for each
+ *  column and then by fixed-size records until the end of the file. */
+struct TapeHeader
+{
+    static constexpr char MAGIC[8] = {'S', 'I', 'M', 'T', 'A', 'P', 'E', '\0'};
+    static constexpr uint16_t VERSION = 1;
+
+    char magic[8];
+    uint16_t version;
+    uint16_t field_count;
+    uint32_t record_size;
+    char record_name[16];
+    int64_t price_scale;
+};
+
+static_assert(sizeof(TapeField) == 40 && sizeof(TapeHeader) == 40, "Tape headers must keep records 8-byte aligned");
+
+/** The layout of the records of a binary tape, listing fields in CSV column order. */
+struct TapeSchema
+{
+    std::string_view record_name;
+    size_t record_size;
+    std::vector<TapeField> fields;
+
+    /** Appends the tape header describing this schema to the given buffer. */
+    void appendHeader(std::string& buffer) const
+    {
+        TapeHeader header {};
+        std::memcpy(header.magic, TapeHeader::MAGIC, sizeof(header.magic));
+        header.version = TapeHeader::VERSION;
+        header.field_count = static_cast<uint16_t>(fields.size());
+        header.record_size = static_cast<uint32_t>(record_size);
+        copyText(header.record_name, record_name);
+        header.price_scale = Price::SCALE;
+
+        buffer.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        buffer.append(reinterpret_cast<const char*>(fields.data()), fields.size() * sizeof(TapeField));
+    }
+
+    /** Returns the description of a field at the given offset of a record. */
+    static TapeField field(std::string_view name, TapeFieldType type, size_t offset, size_t size)
+    {
+        TapeField field {};
+        copyText(field.name, name);
+        field.type = type;
+        field.size = static_cast<uint16_t>(size);
+        field.offset = static_cast<uint16_t>(offset);
+        return field;
+    }
+
+    /** Copies the text into the fixed-size field, truncating it and padding it with zeros. */
+    template <size_t N>
+    static void copyText(char (&field)[N], std::string_view text)
+    {
+        std::memset(field, 0, N);
+        std::memcpy(field, text.data(), std::min(text.size(), N - 1));
+    }
+};
+
+/** Appends the given record to the buffer as it is laid out in memory. */
+template <typename Record>
+void appendTapeRecord(std::string& buffer, Record const& record)
+{
+    buffer.append(reinterpret_cast<const char*>(&record), sizeof(Record));
+}
+
+/** A row of the trade tape. */
+struct TradeRecord
+{
+    static constexpr std::string_view NAME = "trade";
+
+    uint64_t timestamp;
+    Price price;
+    double buyer_priv_value;
+    double seller_priv_value;
+    int32_t id;
+    int32_t quantity;
+    int32_t buyer_id;
+    int32_t seller_id;
+    int32_t aggressing_order_id;
+    int32_t resting_order_id;
+    char ticker[16];
+
+    static TapeSchema const& schema()
+    {
+        static const TapeSchema schema {NAME, sizeof(TradeRecord), {
+            TapeSchema::field("id", TapeFieldType::INT32, offsetof(TradeRecord, id), sizeof(int32_t)),
+            TapeSchema::field("ticker", TapeFieldType::TEXT, offsetof(TradeRecord, ticker), sizeof(ticker)),
+            TapeSchema::field("quantity", TapeFieldType::INT32, offsetof(TradeRecord, quantity), sizeof(int32_t)),
+            TapeSchema::field("price", TapeFieldType::PRICE, offsetof(TradeRecord, price), sizeof(Price)),
+            TapeSchema::field("timestamp", TapeFieldType::UINT64, offsetof(TradeRecord, timestamp), sizeof(uint64_t)),
+            TapeSchema::field("buyer_id", TapeFieldType::INT32, offsetof(TradeRecord, buyer_id), sizeof(int32_t)),
+            TapeSchema::field("seller_id", TapeFieldType::INT32, offsetof(TradeRecord, seller_id), sizeof(int32_t)),
+            TapeSchema::field("aggressing_order_id", TapeFieldType::INT32, offsetof(TradeRecord, aggressing_order_id), sizeof(int32_t)),
+            TapeSchema::field("resting_order_id", TapeFieldType::INT32, offsetof(TradeRecord, resting_order_id), sizeof(int32_t)),
+            TapeSchema::field("buyer_priv_value", TapeFieldType::FLOAT64, offsetof(TradeRecord, buyer_priv_value), sizeof(double)),
+            TapeSchema::field("seller_priv_value", TapeFieldType::FLOAT64, offsetof(TradeRecord, seller_priv_value), sizeof(double))
+        }};
+        return schema;
+    }
+};
+
+/** A row of the market data feed. */
+struct MarketDataRecord
+{
+    static constexpr std::string_view NAME = "market_data";
+
+    uint64_t timestamp;
+    Price best_bid;
+    Price best_ask;
+    int32_t best_bid_size;
+    int32_t best_ask_size;
+    int32_t bids_volume;
+    int32_t asks_volume;
+    int32_t bids_count;
+    int32_t asks_count;
+    char ticker[16];
+
+    static TapeSchema const& schema()
+    {
+        static const TapeSchema schema {NAME, sizeof(MarketDataRecord), {
+            TapeSchema::field("timestamp", TapeFieldType::UINT64, offsetof(MarketDataRecord, timestamp), sizeof(uint64_t)),
+            TapeSchema::field("ticker", TapeFieldType::TEXT, offsetof(MarketDataRecord, ticker), sizeof(ticker)),
+            TapeSchema::field("best_bid", TapeFieldType::PRICE, offsetof(MarketDataRecord, best_bid), sizeof(Price)),
+            TapeSchema::field("best_ask", TapeFieldType::PRICE, offsetof(MarketDataRecord, best_ask), sizeof(Price)),
+            TapeSchema::field("best_bid_size", TapeFieldType::INT32, offsetof(MarketDataRecord, best_bid_size), sizeof(int32_t)),
+            TapeSchema::field("best_ask_size", TapeFieldType::INT32, offsetof(MarketDataRecord, best_ask_size), sizeof(int32_t)),
+            TapeSchema::field("bids_volume", TapeFieldType::INT32, offsetof(MarketDataRecord, bids_volume), sizeof(int32_t)),
+            TapeSchema::field("asks_volume", TapeFieldType::INT32, offsetof(MarketDataRecord, asks_volume), sizeof(int32_t)),
+            TapeSchema::field("bids_count", TapeFieldType::INT32, offsetof(MarketDataRecord, bids_count), sizeof(int32_t)),
+            TapeSchema::field("asks_count", TapeFieldType::INT32, offsetof(MarketDataRecord, asks_count), sizeof(int32_t))
+        }};
+        return schema;
+    }
+};
+
+/** A row of the message tape. */
+struct MessageRecord
+{
+    static constexpr std::string_view NAME = "message";
+
+    uint64_t timestamp_sent;
+    uint64_t timestamp_received;
+    uint64_t timestamp_processed;
+    int32_t sender_id;
+    int32_t padding;
+
+    static TapeSchema const& schema()
+    {
+        static const TapeSchema schema {NAME, sizeof(MessageRecord), {
+            TapeSchema::field("sender_id", TapeFieldType::INT32, offsetof(MessageRecord, sender_id), sizeof(int32_t)),
+            TapeSchema::field("timestamp_sent", TapeFieldType::UINT64, offsetof(MessageRecord, timestamp_sent), sizeof(uint64_t)),
+            TapeSchema::field("timestamp_received", TapeFieldType::UINT64, offsetof(MessageRecord, timestamp_received), sizeof(uint64_t)),
+            TapeSchema::field("timestamp_processed", TapeFieldType::UINT64, offsetof(MessageRecord, timestamp_processed), sizeof(uint64_t))
+        }};
+        return schema;
+    }
+};
+
+static_assert(sizeof(TradeRecord) % 8 == 0 && sizeof(MarketDataRecord) % 8 == 0 && sizeof(MessageRecord) % 8 == 0,
+    "Tape records must keep the following records 8-byte aligned");
+
+#endif
@@ -0,0 +1,183 @@
+#ifndef TAPE_READER_HPP
+#define TAPE_READER_HPP
+
+#include <span>
+#include <string>
+#include <string_view>
+#include <ostream>
+#include <stdexcept>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "tapeformat.hpp"
+
+/** Read-only view of a binary tape mapped into memory. Records are used in place without any
+ *  parsing, either as raw bytes described by the tape's fields or as the record type it holds.
+ *  A partially written last record, e.g. after a crash, is ignored. */
+class TapeReader
+{
+public:
+
+    TapeReader(std::string const& path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("Failed to open tape " + path);
+
+        struct stat file_stat;
+        if (::fstat(fd, &file_stat) != 0)
+        {
+            ::close(fd);
+            throw std::runtime_error("Failed to read the size of tape " + path);
+        }
+        size_ = static_cast<size_t>(file_stat.st_size);
+        if (size_ < sizeof(TapeHeader))
+        {
+            ::close(fd);
+            throw std::runtime_error("Tape " + path + " is too short to hold a header");
+        }
+
+        void* memory = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (memory == MAP_FAILED) throw std::runtime_error("Failed to map tape " + path);
+        data_ = static_cast<const std::byte*>(memory);
+        ::madvise(memory, size_, MADV_SEQUENTIAL);
+
+        // Validate the header before trusting any offsets in it
+        header_ = reinterpret_cast<const TapeHeader*>(data_);
+        records_offset_ = sizeof(TapeHeader) + header_->field_count * sizeof(TapeField);
+        if (std::memcmp(header_->magic, TapeHeader::MAGIC, sizeof(TapeHeader::MAGIC)) != 0
+            || header_->version != TapeHeader::VERSION
+            || header_->record_size == 0
+            || records_offset_ > size_)
+        {
+            ::munmap(memory, size_);
+            throw std::runtime_error(path + " is not a binary tape");
+        }
+        count_ = (size_ - records_offset_) / header_->record_size;
+    }
+
+    TapeReader(const TapeReader&) = delete;
+    TapeReader& operator=(const TapeReader&) = delete;
+
+    ~TapeReader()
+    {
+        ::munmap(const_cast<std::byte*>(data_), size_);
+    }
+
+    /** Returns the header of the tape. */
+    TapeHeader const& header() const { return *header_; }
+
+    /** Returns the name of the type of records in the tape. */
+    std::string_view recordName() const
+    {
+        return std::string_view{header_->record_name, strnlen(header_->record_name, sizeof(header_->record_name))};
+    }
+
+    /** Returns the fields of the records in CSV column order. */
+    std::span<const TapeField> fields() const
+    {
+        return {reinterpret_cast<const TapeField*>(data_ + sizeof(TapeHeader)), header_->field_count};
+    }
+
+    /** Returns the number of complete records in the tape. */
+    size_t size() const { return count_; }
+
+    /** Returns the bytes of the record at the given index. */
+    const std::byte* record(size_t index) const
+    {
+        return data_ + records_offset_ + index * header_->record_size;
+    }
+
+    /** Returns the records of the tape as the given record type, which must match the tape. */
+    template <typename Record>
+    std::span<const Record> records() const
+    {
+        if (recordName() != Record::NAME || header_->record_size != sizeof(Record))
+        {
+            throw std::runtime_error("Tape holds " + std::string{recordName()} + " records, not " + std::string{Record::NAME});
+        }
+        return {reinterpret_cast<const Record*>(data_ + records_offset_), count_};
+    }
+
+    /** Writes the tape as CSV, with the same columns and formatting as a CSV tape. */
+    void writeCSV(std::ostream& os) const
+    {
+        std::span<const TapeField> columns = fields();
+        for (size_t i = 0; i < columns.size(); ++i)
+        {
+            os << (i > 0 ? "," : "") << std::string_view{columns[i].name, strnlen(columns[i].name, sizeof(columns[i].name))};
+        }
+        os << "\n";
+
+        std::string row;
+        for (size_t index = 0; index < count_; ++index)
+        {
+            row.clear();
+            const std::byte* bytes = record(index);
+            for (size_t i = 0; i < columns.size(); ++i)
+            {
+                if (i > 0) row += ',';
+                appendField(row, columns[i], bytes + columns[i].offset);
+            }
+            row += '\n';
+            os.write(row.data(), row.size());
+        }
+    }
+
+private:
+
+    /** Formats a single field of a record as it appears in CSV tapes. */
+    void appendField(std::string& row, TapeField const& field, const std::byte* value) const
+    {
+        switch (field.type)
+        {
+            case TapeFieldType::INT32:
+                row += std::to_string(load<int32_t>(value));
+                break;
+            case TapeFieldType::UINT64:
+                row += std::to_string(load<uint64_t>(value));
+                break;
+            case TapeFieldType::FLOAT64:
+                row += std::to_string(load<double>(value));
+                break;
+            case TapeFieldType::PRICE:
+            {
+                // Rescale in case the tape was written with a different price precision
+                int64_t units = load<int64_t>(value);
+                if (header_->price_scale != Price::SCALE)
+                {
+                    units = units * Price::SCALE / header_->price_scale;
+                }
+                row += Price::fromUnits(units).toString();
+                break;
+            }
+            case TapeFieldType::TEXT:
+            {
+                const char* text = reinterpret_cast<const char*>(value);
+                row.append(text, strnlen(text, field.size));
+                break;
+            }
+            default:
+                throw std::runtime_error("Unknown field type in tape");
+        }
+    }
+
+    template <typename T>
+    static T load(const std::byte* value)
+    {
+        T result;
+        std::memcpy(&result, value, sizeof(T));
+        return result;
+    }
+
+    const std::byte* data_ = nullptr;
+    size_t size_ = 0;
+    const TapeHeader* header_ = nullptr;
+    size_t records_offset_ = 0;
+    size_t count_ = 0;
+};
+
+#endif
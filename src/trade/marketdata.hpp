@@ -7,31 +7,41 @@
 #include <boost/archive/text_iarchive.hpp>
 #include <boost/serialization/string.hpp>
 
+#include "../order/price.hpp"
 #include "../utilities/csvprintable.hpp"
 
+/** The Level 1 statistics of a book. Kept current by the order book on every change,
+ *  so that market data is published by copying them as they are. */
+struct TopOfBook
+{
+    /** Placeholder for prices not available, e.g. the best bid of an empty book. */
+    static constexpr Price NO_PRICE = Price::fromUnits(-Price::SCALE);
+
+    Price best_bid = NO_PRICE;
+    Price best_ask = NO_PRICE;
+    int best_bid_size = 0;
+    int best_ask_size = 0;
+
+    int bids_volume = 0;
+    int asks_volume = 0;
+    int bids_count = 0;
+    int asks_count = 0;
+
+    Price last_price_traded = NO_PRICE;
+    int last_quantity_traded = 0;
+
+    Price high_price = NO_PRICE;
+    Price low_price = NO_PRICE;
+    int cumulative_volume_traded = 0;
+    int trades_count = 0;
+};
+
 /** The Level 1 Market Data Feed **/
-class MarketData : public CSVPrintable, std::enable_shared_from_this<MarketData> {
+class MarketData : public CSVPrintable, public TopOfBook, std::enable_shared_from_this<MarketData> {
     public:
         MarketData() = default;
 
         std::string ticker;
-        double best_bid;
-        double best_ask;
-        int best_bid_size;
-        int best_ask_size;
-
-        int bids_volume;
-        int asks_volume;
-        int bids_count;
-        int asks_count;
-
-        double last_price_traded;
-        int last_quantity_traded;
-
-        double high_price;
-        double low_price;
-        int cumulative_volume_traded;
-        int trades_count;
 
         unsigned long long timestamp;
 
@@ -42,7 +52,19 @@ class MarketData : public CSVPrintable, std::enable_shared_from_this<MarketData>
 
         std::string toCSV() const override
         {
-            return std::to_string(timestamp) + "," + ticker + "," + std::to_string(best_bid) + "," + std::to_string(best_ask) + "," + std::to_string(best_bid_size) + "," + std::to_string(best_ask_size) + "," + std::to_string(bids_volume) + "," + std::to_string(asks_volume) + "," + std::to_string(bids_count) + "," + std::to_string(asks_count);
+            return std::to_string(timestamp) + "," + ticker + "," + best_bid.toString() + "," + best_ask.toString() + "," + std::to_string(best_bid_size) + "," + std::to_string(best_ask_size) + "," + std::to_string(bids_volume) + "," + std::to_string(asks_volume) + "," + std::to_string(bids_count) + "," + std::to_string(asks_count);
+        }
+
+        TapeSchema const& describeTapeSchema() const override
+        {
+            return MarketDataRecord::schema();
+        }
+
+        void appendTapeRecord(std::string& buffer) const override
+        {
+            MarketDataRecord record {timestamp, best_bid, best_ask, best_bid_size, best_ask_size, bids_volume, asks_volume, bids_count, asks_count};
+            TapeSchema::copyText(record.ticker, ticker);
+            ::appendTapeRecord(buffer, record);
         }
 
     private:
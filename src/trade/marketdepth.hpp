@@ -0,0 +1,148 @@
+#ifndef MARKET_DEPTH_HPP
+#define MARKET_DEPTH_HPP
+
+#include <map>
+#include <vector>
+#include <functional>
+
+#include <boost/archive/text_oarchive.hpp>
+#include <boost/archive/text_iarchive.hpp>
+
+#include "../order/order.hpp"
+#include "../order/price.hpp"
+
+/** A change to the aggregate size of a single price level, as sent on the level 2 feed. */
+struct DepthUpdate
+{
+    enum class Action: int {
+        NEW,                         // The level appeared within the subscribed depth
+        CHANGE,                      // The aggregate size of the level changed
+        DELETE                       // The level emptied or fell out of the subscribed depth
+    };
+
+    Order::Side side;
+    Price price;
+    int size;
+    Action action;
+
+private:
+
+    friend class boost::serialization::access;
+    template<class Archive>
+    void serialize(Archive & ar, const unsigned int version)
+    {
+        ar & side;
+        ar & price;
+        ar & size;
+        ar & action;
+    }
+};
+
+/** The price levels of a book as last published on the level 2 feed, used to turn the levels
+ *  changed by matching into updates for the full book or for the top levels of each side. */
+class MarketDepth
+{
+public:
+
+    /** Records the new aggregate size of the given level, appending the resulting full book update if any. */
+    void apply(Order::Side side, Price price, int size, std::vector<DepthUpdate>& updates)
+    {
+        if (side == Order::Side::BID)
+        {
+            apply(bids_, side, price, size, updates);
+        }
+        else
+        {
+            apply(asks_, side, price, size, updates);
+        }
+    }
+
+    /** Forgets all levels. */
+    void clear()
+    {
+        bids_.clear();
+        asks_.clear();
+    }
+
+    /** Fills the given vector with up to the given number of best levels on each side, bids first. */
+    void top(size_t depth, std::vector<DepthUpdate>& levels) const
+    {
+        levels.clear();
+        top(bids_, Order::Side::BID, depth, levels);
+        top(asks_, Order::Side::ASK, depth, levels);
+    }
+
+    /** Appends the updates turning the previous top levels into the current ones. Both must be ordered as by top. */
+    static void diff(std::vector<DepthUpdate> const& previous, std::vector<DepthUpdate> const& current, std::vector<DepthUpdate>& updates)
+    {
+        auto old_level = previous.begin();
+        auto new_level = current.begin();
+        while (old_level != previous.end() || new_level != current.end())
+        {
+            if (new_level == current.end() || (old_level != previous.end() && before(*old_level, *new_level)))
+            {
+                updates.push_back({old_level->side, old_level->price, 0, DepthUpdate::Action::DELETE});
+                ++old_level;
+            }
+            else if (old_level == previous.end() || before(*new_level, *old_level))
+            {
+                updates.push_back({new_level->side, new_level->price, new_level->size, DepthUpdate::Action::NEW});
+                ++new_level;
+            }
+            else
+            {
+                if (old_level->size != new_level->size)
+                {
+                    updates.push_back({new_level->side, new_level->price, new_level->size, DepthUpdate::Action::CHANGE});
+                }
+                ++old_level;
+                ++new_level;
+            }
+        }
+    }
+
+private:
+
+    template <typename Levels>
+    static void apply(Levels& levels, Order::Side side, Price price, int size, std::vector<DepthUpdate>& updates)
+    {
+        auto it = levels.find(price);
+        if (it == levels.end())
+        {
+            if (size == 0) return;
+            levels.emplace(price, size);
+            updates.push_back({side, price, size, DepthUpdate::Action::NEW});
+        }
+        else if (size == 0)
+        {
+            levels.erase(it);
+            updates.push_back({side, price, 0, DepthUpdate::Action::DELETE});
+        }
+        else if (it->second != size)
+        {
+            it->second = size;
+            updates.push_back({side, price, size, DepthUpdate::Action::CHANGE});
+        }
+    }
+
+    template <typename Levels>
+    static void top(Levels const& levels, Order::Side side, size_t depth, std::vector<DepthUpdate>& out)
+    {
+        for (auto it = levels.begin(); it != levels.end() && depth > 0; ++it, --depth)
+        {
+            out.push_back({side, it->first, it->second, DepthUpdate::Action::NEW});
+        }
+    }
+
+    /** Returns true if the first level is listed before the second by top: bids before asks, best prices first. */
+    static bool before(DepthUpdate const& a, DepthUpdate const& b)
+    {
+        if (a.side != b.side) return a.side == Order::Side::BID;
+        return a.side == Order::Side::BID ? a.price > b.price : a.price < b.price;
+    }
+
+    std::map<Price, int, std::greater<Price>> bids_;
+    std::map<Price, int> asks_;
+};
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef ORDER_EVENT_HPP
+#define ORDER_EVENT_HPP
+
+#include <boost/archive/text_oarchive.hpp>
+#include <boost/archive/text_iarchive.hpp>
+
+#include "../order/order.hpp"
+#include "../order/price.hpp"
+
+/** A change to a single resting order, as sent on the market by order feed. */
+struct OrderEvent
+{
+    enum class Type: int {
+        ADD,                         // The order started resting in the book with the given quantity
+        EXECUTE,                     // The given quantity of the order traded, removing it once filled
+        DELETE                       // The order was cancelled with the given quantity left
+    };
+
+    Type type;
+    Order::Side side;
+    int order_id;
+    Price price;
+    int quantity;
+
+private:
+
+    friend class boost::serialization::access;
+    template<class Archive>
+    void serialize(Archive & ar, const unsigned int version)
+    {
+        ar & type;
+        ar & side;
+        ar & order_id;
+        ar & price;
+        ar & quantity;
+    }
+};
+
+#endif
@@ -10,6 +10,7 @@
 #include <boost/serialization/string.hpp>
 #include <boost/serialization/shared_ptr.hpp>
 
+#include "../order/price.hpp"
 #include "../utilities/csvprintable.hpp"
 
 class TradeFactory;
@@ -27,7 +28,7 @@ public:
     int id;
     std::string ticker;
     int quantity;
-    double price;
+    Price price;
     unsigned long long timestamp = 0;
     int buyer_id;
     int seller_id;
@@ -44,7 +45,19 @@ public:
 
     std::string toCSV() const override
     {
-        return std::to_string(id) + "," + ticker + "," + std::to_string(quantity) + "," + std::to_string(price) + "," + std::to_string(timestamp) + "," + std::to_string(buyer_id) + "," + std::to_string(seller_id) + "," + std::to_string(aggressing_order_id) + "," + std::to_string(resting_order_id) + "," + std::to_string(buyer_priv_value) + "," + std::to_string(seller_priv_value);
+        return std::to_string(id) + "," + ticker + "," + std::to_string(quantity) + "," + price.toString() + "," + std::to_string(timestamp) + "," + std::to_string(buyer_id) + "," + std::to_string(seller_id) + "," + std::to_string(aggressing_order_id) + "," + std::to_string(resting_order_id) + "," + std::to_string(buyer_priv_value) + "," + std::to_string(seller_priv_value);
+    }
+
+    TapeSchema const& describeTapeSchema() const override
+    {
+        return TradeRecord::schema();
+    }
+
+    void appendTapeRecord(std::string& buffer) const override
+    {
+        TradeRecord record {timestamp, price, buyer_priv_value, seller_priv_value, id, quantity, buyer_id, seller_id, aggressing_order_id, resting_order_id};
+        TapeSchema::copyText(record.ticker, ticker);
+        ::appendTapeRecord(buffer, record);
     }
 
 private:
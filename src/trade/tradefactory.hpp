@@ -4,6 +4,7 @@
 #include "trade.hpp"
 #include "../order/limitorder.hpp"
 #include "../order/marketorder.hpp"
+#include "../utilities/memorypool.hpp"
 
 class TradeFactory
 {
@@ -11,10 +12,19 @@ public:
 
     TradeFactory() = default;
 
+    /** Creates a factory drawing trades from the given pool instead of the heap.
+     *  Ids are offset and strided so that several factories can share one id space. */
+    TradeFactory(ObjectPool<Trade>* trade_pool, int id_offset = 0, int id_stride = 1)
+    : trade_pool_{trade_pool},
+      id_offset_{id_offset},
+      id_stride_{id_stride}
+    {
+    }
+
     TradePtr createFromLimitOrders(LimitOrderPtr resting_order, LimitOrderPtr aggressing_order)
     {
-        std::shared_ptr<Trade> trade = std::make_shared<Trade>();
-        trade->id = ++trade_id_;
+        std::shared_ptr<Trade> trade = trade_pool_ ? trade_pool_->create() : std::make_shared<Trade>();
+        trade->id = nextTradeId();
         trade->ticker = resting_order->ticker;
         trade->quantity = std::min(resting_order->remaining_quantity, aggressing_order->remaining_quantity);
         trade->price = resting_order->price;
@@ -42,8 +52,8 @@ public:
 
     TradePtr createFromLimitAndMarketOrders(LimitOrderPtr resting_order, MarketOrderPtr aggressing_order)
     {
-        std::shared_ptr<Trade> trade = std::make_shared<Trade>();
-        trade->id = ++trade_id_;
+        std::shared_ptr<Trade> trade = trade_pool_ ? trade_pool_->create() : std::make_shared<Trade>();
+        trade->id = nextTradeId();
         trade->ticker = resting_order->ticker;
         trade->quantity = std::min(resting_order->remaining_quantity, aggressing_order->remaining_quantity);
         trade->price = resting_order->price;
@@ -76,8 +86,16 @@ public:
 
 private:
 
+    int nextTradeId()
+    {
+        return (trade_id_++) * id_stride_ + id_offset_ + 1;
+    }
+
     int trade_id_ = 0;
     int volume_traded_ = 0;
+    ObjectPool<Trade>* trade_pool_ = nullptr;
+    int id_offset_ = 0;
+    int id_stride_ = 1;
 };
 
 #endif
\ No newline at end of file
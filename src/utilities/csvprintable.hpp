@@ -7,6 +7,8 @@
 #include <boost/archive/text_oarchive.hpp>
 #include <boost/archive/text_iarchive.hpp>
 
+#include "../tape/tapeformat.hpp"
+
 class CSVPrintable
 {
 public:
@@ -16,6 +18,12 @@ public:
     virtual std::string describeCSVHeaders() const = 0;
     virtual std::string toCSV() const = 0;
 
+    /** Returns the layout of the row in binary tapes. */
+    virtual TapeSchema const& describeTapeSchema() const = 0;
+
+    /** Appends the row to the given buffer as a binary tape record. */
+    virtual void appendTapeRecord(std::string& buffer) const = 0;
+
 private:
 
     /** Enable serialisation of derived classes. */
@@ -5,21 +5,51 @@
 #include <string>
 #include <fstream>
 #include <vector>
+#include <mutex>
+#include <atomic>
 #include <thread>
+#include <chrono>
 
-#include "syncqueue.hpp"
+#include "ringqueue.hpp"
+#include "logger.hpp"
 #include "csvprintable.hpp"
 
+/** When the rows buffered by a CSV writer are written to the file. */
+struct CSVFlushPolicy
+{
+    size_t buffer_size = 1 << 20;                   // Bytes buffered before a write
+    std::chrono::milliseconds interval {100};       // Longest time a row stays buffered
+};
+
+/** Writes CSV rows, or binary tape records, to a file on a dedicated I/O thread. Writers only queue the rows on a lock-free
+ *  ring, so they never wait on disk; rows are formatted by the I/O thread, which must therefore
+ *  be the only reader of a row once written. Should the disk fall behind until the ring is full, further rows
+ *  spill to an overflow list the I/O thread drains once it has caught up with the ring, keeping their order.
+ *  Formatted rows are buffered and written to the file in one go once the buffer fills up or the flush interval elapses. */
 class CSVWriter
 {
 public:
 
+    /** Number of rows queued on the ring before further rows spill to the overflow list. */
+    static constexpr size_t QUEUE_CAPACITY = 65536;
+
+    /** Maximum number of rows formatted per pass over the queue. */
+    static constexpr size_t ROW_BATCH_SIZE = 256;
+
+    /** How often the I/O thread checks for new rows while it has buffered rows to flush. */
+    static constexpr std::chrono::milliseconds POLL_INTERVAL {1};
+
     CSVWriter() = delete;
 
-    CSVWriter(std::string path)
+    CSVWriter(std::string path, TapeFormat format = TapeFormat::CSV, CSVFlushPolicy policy = CSVFlushPolicy{})
     : path_{path},
-      file_{path}
+      file_{path, std::ios::out | std::ios::binary},
+      format_{format},
+      policy_{policy},
+      rows_{QUEUE_CAPACITY}
     {
+        buffer_.reserve(policy_.buffer_size);
+        io_thread_ = std::thread([this](){ run(); });
     };
 
     ~CSVWriter()
@@ -27,29 +57,168 @@ public:
         stop();
     };
 
-    /** Stops the CSV writer and closes the file. */
+    /** Stops accepting rows, writes out all rows queued so far and closes the file. */
     void stop()
     {
+        if (!io_thread_.joinable()) return;
+        rows_.close();
+        io_thread_.join();
         file_.close();
+        if (spilled_ > 0)
+        {
+            LOG_WARN << "CSV writer " << path_ << " fell behind, " << spilled_ << " rows spilled past its queue";
+        }
     }
 
-    /** Writes the given item as a CSV row immediately. */
+    /** Queues the given item to be written as a CSV row, without waiting on the I/O thread. */
     void writeRow(CSVPrintablePtr item) {
-        if (!started_) 
+        // Once spilling, rows keep going to the overflow list until the I/O thread has drained it, so they stay in order
+        if (spilling_.load(std::memory_order_acquire) && spill(item)) return;
+
+        if (rows_.closed())
         {
-            file_ << item->describeCSVHeaders() << std::endl;
-            started_ = true;
+            LOG_WARN << "Row dropped by stopped CSV writer " << path_;
+        }
+        else if (!rows_.try_push(item))
+        {
+            std::lock_guard lock{overflow_mutex_};
+            overflow_.push_back(std::move(item));
+            spilling_.store(true, std::memory_order_release);
+            ++spilled_;
+        }
+    }
+
+    /** Queues the given items to be written as CSV rows. */
+    void writeRows(std::vector<CSVPrintablePtr> const& items) {
+        for (CSVPrintablePtr const& item : items)
+        {
+            writeRow(item);
         }
-        file_ << item->toCSV() << std::endl;
     }
 
 private:
 
+    /** Adds the item to the overflow list if still spilling, returning false if the I/O thread has drained it since. */
+    bool spill(CSVPrintablePtr& item)
+    {
+        std::lock_guard lock{overflow_mutex_};
+        if (!spilling_.load(std::memory_order_relaxed)) return false;
+        overflow_.push_back(std::move(item));
+        ++spilled_;
+        return true;
+    }
+
+    /** Takes the rows spilled past the ring, once the ring holding the rows queued before them is empty. */
+    bool takeOverflow(std::vector<CSVPrintablePtr>& rows)
+    {
+        if (!spilling_.load(std::memory_order_acquire)) return false;
+        std::lock_guard lock{overflow_mutex_};
+        rows.swap(overflow_);
+        spilling_.store(false, std::memory_order_release);
+        return true;
+    }
+
+    /** Formats queued rows into the buffer and writes it out according to the flush policy until stopped. */
+    void run()
+    {
+        std::vector<CSVPrintablePtr> batch(ROW_BATCH_SIZE);
+        std::vector<CSVPrintablePtr> overflow;
+        std::chrono::steady_clock::time_point last_flush = std::chrono::steady_clock::now();
+        for (;;)
+        {
+            size_t count = rows_.try_pop_n(batch.data(), batch.size());
+            if (count == 0 && takeOverflow(overflow))
+            {
+                for (CSVPrintablePtr const& row : overflow)
+                {
+                    append(*row);
+                }
+                overflow.clear();
+            }
+            else if (count == 0 && rows_.closed())
+            {
+                // Rows queued before the writer stopped are still in the ring or the overflow list
+                count = rows_.try_pop_n(batch.data(), batch.size());
+                if (count == 0 && !spilling_.load(std::memory_order_acquire)) break;
+            }
+            else if (count == 0 && buffer_.empty())
+            {
+                // Nothing to flush, so sleep until the next row arrives
+                batch[0] = rows_.pop();
+                if (batch[0] == nullptr) continue;
+                count = 1;
+            }
+            else if (count == 0)
+            {
+                if (std::chrono::steady_clock::now() - last_flush >= policy_.interval)
+                {
+                    flush();
+                    last_flush = std::chrono::steady_clock::now();
+                }
+                std::this_thread::sleep_for(POLL_INTERVAL);
+                continue;
+            }
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                append(*batch[i]);
+                batch[i] = nullptr;
+            }
+            if (buffer_.size() >= policy_.buffer_size)
+            {
+                flush();
+                last_flush = std::chrono::steady_clock::now();
+            }
+        }
+        flush();
+    }
+
+    /** Formats the given item into the buffer, preceded by the headers for the first row. */
+    void append(CSVPrintable const& item)
+    {
+        if (format_ == TapeFormat::BINARY)
+        {
+            if (!started_) item.describeTapeSchema().appendHeader(buffer_);
+            item.appendTapeRecord(buffer_);
+        }
+        else
+        {
+            if (!started_)
+            {
+                buffer_ += item.describeCSVHeaders();
+                buffer_ += '\n';
+            }
+            buffer_ += item.toCSV();
+            buffer_ += '\n';
+        }
+        started_ = true;
+    }
+
+    /** Writes the buffered rows to the file. */
+    void flush()
+    {
+        if (buffer_.empty()) return;
+        file_.write(buffer_.data(), buffer_.size());
+        file_.flush();
+        buffer_.clear();
+    }
+
     std::string path_;
     std::ofstream file_;
+    TapeFormat format_;
+    CSVFlushPolicy policy_;
+    RingQueue<CSVPrintablePtr> rows_;
+
+    /** Rows written while the ring was full, guarded by the overflow mutex. */
+    std::mutex overflow_mutex_;
+    std::vector<CSVPrintablePtr> overflow_;
+    std::atomic<bool> spilling_ = false;
+    size_t spilled_ = 0;
+    std::string buffer_;
     bool started_ = false;
+    std::thread io_thread_;
 };
 
 typedef std::shared_ptr<CSVWriter> CSVWriterPtr;
 
-#endif
\ No newline at end of file
+#endif
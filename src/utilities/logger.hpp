@@ -0,0 +1,367 @@
+#ifndef LOGGER_HPP
+#define LOGGER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#include "ringqueue.hpp"
+
+enum class LogLevel
+{
+    TRACE,
+    DEBUG,
+    INFO,
+    WARN,
+    ERROR,
+    OFF
+};
+
+/** Lowest level compiled into the binary, lines below it are removed entirely. */
+#ifndef COMPILED_LOG_LEVEL
+#define COMPILED_LOG_LEVEL LogLevel::TRACE
+#endif
+
+/** Returns the name of the given log level as printed in the log. */
+inline std::string_view to_string(LogLevel level)
+{
+    switch (level)
+    {
+        case LogLevel::TRACE: return "TRACE";
+        case LogLevel::DEBUG: return "DEBUG";
+        case LogLevel::INFO: return "INFO";
+        case LogLevel::WARN: return "WARN";
+        case LogLevel::ERROR: return "ERROR";
+        default: return "OFF";
+    }
+};
+
+/** Parses a log level name as given on the command line. */
+inline LogLevel parseLogLevel(std::string_view name)
+{
+    if (name == "trace") return LogLevel::TRACE;
+    if (name == "debug") return LogLevel::DEBUG;
+    if (name == "info") return LogLevel::INFO;
+    if (name == "warn") return LogLevel::WARN;
+    if (name == "error") return LogLevel::ERROR;
+    if (name == "off") return LogLevel::OFF;
+    throw std::runtime_error("Unknown log level " + std::string{name});
+};
+
+/** Asynchronous logger for diagnostic output. Each logging thread formats its lines into its own
+ *  single-producer ring, so logging never takes a lock or writes to a stream on the calling thread.
+ *  A background thread drains all rings, orders the lines by time and writes them out in one go.
+ *  Lines are dropped and counted rather than blocking the caller when a ring is full. */
+class Logger
+{
+public:
+
+    /** Number of lines each thread can hold before the background thread drains them. */
+    static constexpr size_t THREAD_BUFFER_SIZE = 1024;
+
+    /** How often the background thread drains the thread buffers. */
+    static constexpr std::chrono::milliseconds FLUSH_INTERVAL {1};
+
+    /** A single formatted log line. Short lines are stored inline to avoid allocating. */
+    struct Record
+    {
+        static constexpr size_t INLINE_SIZE = 192;
+
+        std::chrono::system_clock::time_point time;
+        LogLevel level;
+        size_t length;
+        char text[INLINE_SIZE];
+        std::string overflow;
+
+        std::string_view view() const
+        {
+            return length <= INLINE_SIZE ? std::string_view{text, length} : std::string_view{overflow};
+        }
+    };
+
+    /** Lines logged by a single thread, kept alive until drained after the thread exits. */
+    struct ThreadBuffer
+    {
+        SPSCRingQueue<Record> records {THREAD_BUFFER_SIZE};
+        std::atomic<size_t> dropped = 0;
+        std::atomic<bool> exited = false;
+    };
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    ~Logger()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        stopping_ = true;
+        lock.unlock();
+        cv_.notify_one();
+        writer_thread_.join();
+        drain();
+        stopped_.store(true, std::memory_order_release);
+    }
+
+    /** Returns the process wide logger, starting its background thread on first use. */
+    static Logger& instance()
+    {
+        static Logger logger;
+        return logger;
+    }
+
+    /** Returns true if lines at the given level are logged. */
+    static bool enabled(LogLevel level)
+    {
+        return level >= COMPILED_LOG_LEVEL && level >= level_.load(std::memory_order_relaxed);
+    }
+
+    /** Sets the lowest level logged at runtime. */
+    static void setLevel(LogLevel level)
+    {
+        level_.store(level, std::memory_order_relaxed);
+    }
+
+    /** Queues the given line on the calling thread's buffer. */
+    static void submit(LogLevel level, std::string_view text)
+    {
+        std::chrono::system_clock::time_point time = std::chrono::system_clock::now();
+
+        // Once the logger is gone during shutdown, write the line synchronously instead
+        if (stopped_.load(std::memory_order_acquire))
+        {
+            write(std::cout, time, level, text);
+            std::cout.flush();
+            return;
+        }
+
+        ThreadBuffer& buffer = threadBuffer();
+        Record record {time, level, text.size()};
+        if (text.size() <= Record::INLINE_SIZE)
+        {
+            std::memcpy(record.text, text.data(), text.size());
+        }
+        else
+        {
+            record.overflow = text;
+        }
+        if (!buffer.records.try_push(record))
+        {
+            buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    /** Returns a stream formatting into the calling thread's scratch buffer, cleared for a new line. */
+    static std::ostream& threadStream()
+    {
+        ThreadContext& context = threadContext();
+        context.line.clear();
+        return context.stream;
+    }
+
+    /** Returns the line formatted by the calling thread since the last call to threadStream. */
+    static std::string_view threadLine()
+    {
+        return threadContext().line;
+    }
+
+private:
+
+    /** Appends formatted output to a reusable string, so formatting a line does not allocate once warmed up. */
+    class StringBuffer : public std::streambuf
+    {
+    public:
+
+        StringBuffer(std::string& line)
+        : line_{line}
+        {
+        }
+
+    protected:
+
+        int_type overflow(int_type c) override
+        {
+            if (c != traits_type::eof()) line_.push_back(static_cast<char>(c));
+            return c;
+        }
+
+        std::streamsize xsputn(const char* s, std::streamsize n) override
+        {
+            line_.append(s, n);
+            return n;
+        }
+
+    private:
+
+        std::string& line_;
+    };
+
+    /** Per thread logging state, registered with the logger on the thread's first line. */
+    struct ThreadContext
+    {
+        ThreadContext()
+        : buffer{std::make_shared<ThreadBuffer>()},
+          string_buffer{line},
+          stream{&string_buffer}
+        {
+            line.reserve(Record::INLINE_SIZE);
+            Logger::instance().registerBuffer(buffer);
+        }
+
+        ~ThreadContext()
+        {
+            buffer->exited.store(true, std::memory_order_release);
+        }
+
+        std::shared_ptr<ThreadBuffer> buffer;
+        std::string line;
+        StringBuffer string_buffer;
+        std::ostream stream;
+    };
+
+    Logger()
+    : writer_thread_{[this](){ run(); }}
+    {
+    }
+
+    static ThreadContext& threadContext()
+    {
+        thread_local ThreadContext context;
+        return context;
+    }
+
+    static ThreadBuffer& threadBuffer()
+    {
+        return *threadContext().buffer;
+    }
+
+    static void write(std::ostream& os, std::chrono::system_clock::time_point time, LogLevel level, std::string_view text)
+    {
+        if (text.ends_with('\n')) text.remove_suffix(1);
+
+        std::time_t seconds = std::chrono::system_clock::to_time_t(time);
+        long micros = std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count() % 1000000;
+        std::tm local_time;
+        localtime_r(&seconds, &local_time);
+        os << std::put_time(&local_time, "%H:%M:%S") << "." << std::setfill('0') << std::setw(6) << micros
+        << " " << std::setfill(' ') << std::left << std::setw(5) << to_string(level) << std::right << " " << text << "\n";
+    }
+
+    void registerBuffer(std::shared_ptr<ThreadBuffer> buffer)
+    {
+        std::lock_guard<std::mutex> lock(buffers_mutex_);
+        buffers_.push_back(buffer);
+    }
+
+    /** Drains the thread buffers every flush interval until the logger is destroyed. */
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_)
+        {
+            cv_.wait_for(lock, FLUSH_INTERVAL);
+            lock.unlock();
+            drain();
+            lock.lock();
+        }
+    }
+
+    /** Writes out all queued lines in time order and forgets buffers of exited threads. */
+    void drain()
+    {
+        std::unique_lock<std::mutex> lock(buffers_mutex_);
+        size_t dropped = 0;
+        for (std::shared_ptr<ThreadBuffer> const& buffer : buffers_)
+        {
+            Record record;
+            while (buffer->records.try_pop(record))
+            {
+                pending_.push_back(std::move(record));
+            }
+            dropped += buffer->dropped.exchange(0, std::memory_order_relaxed);
+        }
+        std::erase_if(buffers_, [](std::shared_ptr<ThreadBuffer> const& buffer){
+            return buffer->exited.load(std::memory_order_acquire) && buffer->records.size() == 0;
+        });
+        lock.unlock();
+
+        if (pending_.empty() && dropped == 0) return;
+
+        // Lines of each thread are already in order, so a stable sort keeps them that way
+        std::stable_sort(pending_.begin(), pending_.end(), [](Record const& a, Record const& b){
+            return a.time < b.time;
+        });
+        for (Record const& record : pending_)
+        {
+            write(std::cout, record.time, record.level, record.view());
+        }
+        if (dropped > 0)
+        {
+            write(std::cout, std::chrono::system_clock::now(), LogLevel::WARN, std::to_string(dropped) + " log lines dropped");
+        }
+        std::cout.flush();
+        pending_.clear();
+    }
+
+    inline static std::atomic<LogLevel> level_ = LogLevel::INFO;
+    inline static std::atomic<bool> stopped_ = false;
+
+    std::mutex buffers_mutex_;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+    std::vector<Record> pending_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+    std::thread writer_thread_;
+};
+
+/** Formats a single log line on the calling thread and queues it once the statement ends. */
+class LogLine
+{
+public:
+
+    LogLine(LogLevel level)
+    : level_{level},
+      stream_{Logger::threadStream()}
+    {
+    }
+
+    LogLine(const LogLine&) = delete;
+    LogLine& operator=(const LogLine&) = delete;
+
+    ~LogLine()
+    {
+        Logger::submit(level_, Logger::threadLine());
+    }
+
+    std::ostream& stream() { return stream_; }
+
+private:
+
+    LogLevel level_;
+    std::ostream& stream_;
+};
+
+/** Logs a line streamed after the macro, e.g. LOG_INFO << "Listening on port " << port.
+ *  Arguments are not evaluated when the level is disabled. */
+#define LOG(level) if (!Logger::enabled(level)) ; else LogLine{level}.stream()
+
+#define LOG_TRACE LOG(LogLevel::TRACE)
+#define LOG_DEBUG LOG(LogLevel::DEBUG)
+#define LOG_INFO LOG(LogLevel::INFO)
+#define LOG_WARN LOG(LogLevel::WARN)
+#define LOG_ERROR LOG(LogLevel::ERROR)
+
+#endif
@@ -0,0 +1,354 @@
+#ifndef MEMORY_POOL_HPP
+#define MEMORY_POOL_HPP
+
+#include <new>
+#include <atomic>
+#include <algorithm>
+#include <stdexcept>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <iostream>
+#include <sys/mman.h>
+
+#include "logger.hpp"
+
+/** Slab allocator handing out fixed-size blocks, optionally backed by huge pages.
+ *  Blocks are allocated by a single owning thread but may be freed from any thread: frees
+ *  go to a lock-free return stack which the owner takes over in a single exchange once its
+ *  local free list runs dry, so the owner never pops concurrently with other threads.
+ *  The block size is fixed by the first allocation unless given upfront, so a pool
+ *  can back std::allocate_shared or node-based containers whose node type is internal. */
+class MemoryPool
+{
+public:
+
+    static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    MemoryPool(std::string_view name, size_t blocks_per_slab = 4096, bool huge_pages = false, size_t block_size = 0)
+    : name_{name},
+      blocks_per_slab_{blocks_per_slab},
+      huge_pages_{huge_pages},
+      block_size_{roundUp(block_size)}
+    {
+    }
+
+    MemoryPool(const MemoryPool&) = delete;
+    MemoryPool& operator=(const MemoryPool&) = delete;
+
+    ~MemoryPool()
+    {
+        // Blocks still referenced elsewhere must stay valid, so leak the slabs rather than free them
+        if (inUse() > 0)
+        {
+            LOG_WARN << "Memory pool " << name_ << " destroyed with " << inUse() << " blocks in use";
+            return;
+        }
+        for (Slab const& slab : slabs_)
+        {
+            if (slab.mapped)
+            {
+                munmap(slab.memory, slab.bytes);
+            }
+            else
+            {
+                ::operator delete(slab.memory, std::align_val_t{alignof(std::max_align_t)});
+            }
+        }
+    }
+
+    /** Returns true if a request of the given size is served by the pool, fixing the block size on first use. */
+    bool serves(size_t bytes)
+    {
+        if (block_size_ == 0) block_size_ = roundUp(bytes);
+        return bytes <= block_size_;
+    }
+
+    /** Returns true if a block of the given size was served by the pool. */
+    bool served(size_t bytes) const
+    {
+        return bytes <= block_size_;
+    }
+
+    /** Returns a free block, growing the pool by a slab if none is left. Owner thread only. */
+    void* allocate()
+    {
+        if (free_list_ == nullptr)
+        {
+            free_list_ = returned_.exchange(nullptr, std::memory_order_acquire);
+            if (free_list_ == nullptr) grow();
+        }
+        FreeBlock* block = free_list_;
+        free_list_ = block->next;
+        allocated_.store(allocated_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return block;
+    }
+
+    /** Returns the given block to the pool. Safe to call from any thread. */
+    void deallocate(void* pointer)
+    {
+        FreeBlock* block = static_cast<FreeBlock*>(pointer);
+        block->next = returned_.load(std::memory_order_relaxed);
+        while (!returned_.compare_exchange_weak(block->next, block, std::memory_order_release, std::memory_order_relaxed));
+        freed_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /** Returns the name of the pool used in reports. */
+    std::string_view name() const { return name_; }
+
+    /** Returns the size of each block in bytes, zero before the first allocation. */
+    size_t blockSize() const { return block_size_; }
+
+    /** Returns the number of blocks currently handed out. */
+    size_t inUse() const
+    {
+        return allocated_.load(std::memory_order_relaxed) - freed_.load(std::memory_order_relaxed);
+    }
+
+    /** Returns the number of blocks in all slabs. */
+    size_t capacity() const { return capacity_.load(std::memory_order_relaxed); }
+
+    /** Returns the total number of blocks handed out since creation. */
+    size_t totalAllocated() const { return allocated_.load(std::memory_order_relaxed); }
+
+    /** Prints the pool occupancy. */
+    void report(std::ostream& os) const
+    {
+        os << "Pool " << name_ << ": " << inUse() << "/" << capacity() << " blocks in use, "
+        << totalAllocated() << " allocated in total, " << slabs_.size() << " slabs of "
+        << block_size_ << " byte blocks" << (huge_pages_ ? " on huge pages" : "") << "\n";
+    }
+
+private:
+
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    struct Slab
+    {
+        void* memory;
+        size_t bytes;
+        bool mapped;
+    };
+
+    static size_t roundUp(size_t bytes)
+    {
+        if (bytes == 0) return 0;
+        size_t alignment = alignof(std::max_align_t);
+        return std::max(sizeof(FreeBlock), (bytes + alignment - 1) / alignment * alignment);
+    }
+
+    /** Allocates a new slab and threads its blocks onto the local free list. */
+    void grow()
+    {
+        if (block_size_ == 0) throw std::runtime_error("Memory pool " + name_ + " used before its block size is known");
+
+        Slab slab {nullptr, block_size_ * blocks_per_slab_, false};
+        if (huge_pages_)
+        {
+            slab.bytes = (slab.bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+            slab.memory = mmap(nullptr, slab.bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (slab.memory == MAP_FAILED)
+            {
+                // Fall back to transparent huge pages if no huge pages are reserved
+                slab.memory = mmap(nullptr, slab.bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (slab.memory == MAP_FAILED) throw std::bad_alloc();
+                madvise(slab.memory, slab.bytes, MADV_HUGEPAGE);
+            }
+            slab.mapped = true;
+        }
+        else
+        {
+            slab.memory = ::operator new(slab.bytes, std::align_val_t{alignof(std::max_align_t)});
+        }
+        slabs_.push_back(slab);
+
+        size_t blocks = slab.bytes / block_size_;
+        char* memory = static_cast<char*>(slab.memory);
+        for (size_t i = blocks; i > 0; --i)
+        {
+            FreeBlock* block = reinterpret_cast<FreeBlock*>(memory + (i - 1) * block_size_);
+            block->next = free_list_;
+            free_list_ = block;
+        }
+        capacity_.fetch_add(blocks, std::memory_order_relaxed);
+    }
+
+    std::string name_;
+    size_t blocks_per_slab_;
+    bool huge_pages_;
+    size_t block_size_;
+
+    std::vector<Slab> slabs_;
+    FreeBlock* free_list_ = nullptr;
+    std::atomic<FreeBlock*> returned_ = nullptr;
+
+    std::atomic<size_t> capacity_ = 0;
+    std::atomic<size_t> allocated_ = 0;
+    std::atomic<size_t> freed_ = 0;
+};
+
+/** Standard allocator drawing single objects from a memory pool, falling back to the heap
+ *  for requests larger than the pool's blocks or when no pool is given. */
+template <typename T>
+class PoolAllocator
+{
+public:
+
+    typedef T value_type;
+
+    PoolAllocator() noexcept = default;
+
+    PoolAllocator(MemoryPool* pool) noexcept
+    : pool_{pool}
+    {
+    }
+
+    template <typename U>
+    PoolAllocator(PoolAllocator<U> const& other) noexcept
+    : pool_{other.pool()}
+    {
+    }
+
+    T* allocate(size_t n)
+    {
+        if (pool_ != nullptr && pool_->serves(n * sizeof(T)) && alignof(T) <= alignof(std::max_align_t))
+        {
+            return static_cast<T*>(pool_->allocate());
+        }
+        return std::allocator<T>{}.allocate(n);
+    }
+
+    void deallocate(T* pointer, size_t n)
+    {
+        if (pool_ != nullptr && pool_->served(n * sizeof(T)) && alignof(T) <= alignof(std::max_align_t))
+        {
+            pool_->deallocate(pointer);
+            return;
+        }
+        std::allocator<T>{}.deallocate(pointer, n);
+    }
+
+    MemoryPool* pool() const noexcept { return pool_; }
+
+    template <typename U>
+    bool operator==(PoolAllocator<U> const& other) const noexcept { return pool_ == other.pool(); }
+
+private:
+
+    MemoryPool* pool_ = nullptr;
+};
+
+/** Pool of shared objects of a single type, recycling both the object and its control block. */
+template <typename T>
+class ObjectPool
+{
+public:
+
+    ObjectPool(std::string_view name, size_t blocks_per_slab = 4096, bool huge_pages = false)
+    : pool_{name, blocks_per_slab, huge_pages}
+    {
+    }
+
+    /** Creates a shared object constructed from the given arguments in a pooled block. */
+    template <typename... Args>
+    std::shared_ptr<T> create(Args&&... args)
+    {
+        return std::allocate_shared<T>(PoolAllocator<T>{&pool_}, std::forward<Args>(args)...);
+    }
+
+    MemoryPool& pool() { return pool_; }
+
+    MemoryPool const& pool() const { return pool_; }
+
+private:
+
+    MemoryPool pool_;
+};
+
+/** Pool of shared objects of a single type which keeps released objects alive instead of destroying them,
+ *  so the buffers they own keep their capacity when the objects are reused. Objects come back in the state
+ *  they were released in, so callers overwrite every field. Objects are created by a single owning thread
+ *  but may be released from any thread, through the same kind of return stack as MemoryPool. */
+template <typename T>
+class RecyclingPool
+{
+public:
+
+    RecyclingPool(std::string_view name, size_t blocks_per_slab = 4096, bool huge_pages = false)
+    : pool_{name, blocks_per_slab, huge_pages}
+    {
+    }
+
+    RecyclingPool(const RecyclingPool&) = delete;
+    RecyclingPool& operator=(const RecyclingPool&) = delete;
+
+    ~RecyclingPool()
+    {
+        // Objects still referenced elsewhere must stay valid, so leak them as MemoryPool leaks its slabs
+        if (pool_.inUse() > 0)
+        {
+            for (std::unique_ptr<Node>& node : nodes_)
+            {
+                node.release();
+            }
+        }
+    }
+
+    /** Returns a released object, or a default constructed one if none is left. Owner thread only. */
+    std::shared_ptr<T> create()
+    {
+        if (free_list_ == nullptr)
+        {
+            free_list_ = returned_.exchange(nullptr, std::memory_order_acquire);
+        }
+
+        Node* node = free_list_;
+        if (node != nullptr)
+        {
+            free_list_ = node->next;
+        }
+        else
+        {
+            nodes_.push_back(std::make_unique<Node>());
+            node = nodes_.back().get();
+        }
+        return std::shared_ptr<T>(&node->object, Recycler{this, node}, PoolAllocator<T>{&pool_});
+    }
+
+    /** Returns the pool of control blocks, holding one block for each object in use. */
+    MemoryPool& pool() { return pool_; }
+
+    MemoryPool const& pool() const { return pool_; }
+
+private:
+
+    struct Node
+    {
+        T object;
+        Node* next = nullptr;
+    };
+
+    /** Deleter handing the object back to the pool rather than destroying it. */
+    struct Recycler
+    {
+        RecyclingPool* owner;
+        Node* node;
+
+        void operator()(T*) const
+        {
+            node->next = owner->returned_.load(std::memory_order_relaxed);
+            while (!owner->returned_.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed));
+        }
+    };
+
+    MemoryPool pool_;
+    std::vector<std::unique_ptr<Node>> nodes_;
+    Node* free_list_ = nullptr;
+    std::atomic<Node*> returned_ = nullptr;
+};
+
+#endif
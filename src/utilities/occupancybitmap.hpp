@@ -0,0 +1,150 @@
+#ifndef OCCUPANCY_BITMAP_HPP
+#define OCCUPANCY_BITMAP_HPP
+
+#include <bit>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/** Hierarchical bitmap tracking which slots of a fixed-size array are occupied.
+ *  Each bit of an upper layer summarises one 64-bit word of the layer below, so finding
+ *  the first, last, next or previous occupied slot takes one word scan per layer. */
+class OccupancyBitmap
+{
+public:
+
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    OccupancyBitmap(size_t size)
+    : layers_{}
+    {
+        // Add layers until a single word summarises the whole bitmap
+        do
+        {
+            size = (size + 63) / 64;
+            layers_.push_back(std::vector<uint64_t>(size, 0));
+        }
+        while (size > 1);
+    }
+
+    /** Marks the given slot as occupied. */
+    void set(size_t i)
+    {
+        for (std::vector<uint64_t>& layer : layers_)
+        {
+            bool was_empty = layer[i >> 6] == 0;
+            layer[i >> 6] |= uint64_t{1} << (i & 63);
+            if (!was_empty) break;
+            i >>= 6;
+        }
+    }
+
+    /** Marks the given slot as empty. */
+    void reset(size_t i)
+    {
+        for (std::vector<uint64_t>& layer : layers_)
+        {
+            layer[i >> 6] &= ~(uint64_t{1} << (i & 63));
+            if (layer[i >> 6] != 0) break;
+            i >>= 6;
+        }
+    }
+
+    /** Returns true if the given slot is occupied. */
+    bool test(size_t i) const
+    {
+        return (layers_.front()[i >> 6] >> (i & 63)) & 1;
+    }
+
+    /** Returns true if no slot is occupied. */
+    bool empty() const
+    {
+        return layers_.back().front() == 0;
+    }
+
+    /** Returns the lowest occupied slot or npos if empty. */
+    size_t first() const
+    {
+        return next(0);
+    }
+
+    /** Returns the highest occupied slot or npos if empty. */
+    size_t last() const
+    {
+        return empty() ? npos : descendHigh(layers_.size() - 1, 63 - std::countl_zero(layers_.back().front()));
+    }
+
+    /** Returns the lowest occupied slot at or above the given slot, or npos if none. */
+    size_t next(size_t i) const
+    {
+        for (size_t layer = 0; layer < layers_.size(); ++layer)
+        {
+            size_t word = i >> 6;
+            if (word >= layers_[layer].size()) return npos;
+
+            uint64_t bits = layers_[layer][word] & (~uint64_t{0} << (i & 63));
+            if (bits != 0)
+            {
+                return descendLow(layer, (word << 6) + std::countr_zero(bits));
+            }
+
+            // Continue the search from the next word of this layer
+            i = word + 1;
+        }
+        return npos;
+    }
+
+    /** Returns the highest occupied slot at or below the given slot, or npos if none. */
+    size_t prev(size_t i) const
+    {
+        for (size_t layer = 0; layer < layers_.size(); ++layer)
+        {
+            size_t word = i >> 6;
+            if (word >= layers_[layer].size())
+            {
+                word = layers_[layer].size() - 1;
+                i = (word << 6) + 63;
+            }
+
+            uint64_t bits = layers_[layer][word] & (~uint64_t{0} >> (63 - (i & 63)));
+            if (bits != 0)
+            {
+                return descendHigh(layer, (word << 6) + 63 - std::countl_zero(bits));
+            }
+
+            // Continue the search from the previous word of this layer
+            if (word == 0) return npos;
+            i = word - 1;
+        }
+        return npos;
+    }
+
+private:
+
+    /** Follows the lowest set bits from the given bit of a layer down to a slot. */
+    size_t descendLow(size_t layer, size_t i) const
+    {
+        while (layer > 0)
+        {
+            --layer;
+            i = (i << 6) + std::countr_zero(layers_[layer][i]);
+        }
+        return i;
+    }
+
+    /** Follows the highest set bits from the given bit of a layer down to a slot. */
+    size_t descendHigh(size_t layer, size_t i) const
+    {
+        while (layer > 0)
+        {
+            --layer;
+            i = (i << 6) + 63 - std::countl_zero(layers_[layer][i]);
+        }
+        return i;
+    }
+
+    /** Bit layers, from the slots themselves up to a single summary word. */
+    std::vector<std::vector<uint64_t>> layers_;
+};
+
+#endif
@@ -0,0 +1,222 @@
+#ifndef RING_QUEUE_HPP
+#define RING_QUEUE_HPP
+
+#include <new>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+/** Bounded lock-free FIFO ring for a single consumer and one or many producers.
+ *  Each slot carries a sequence number telling producers and the consumer whose turn it is,
+ *  so producers only contend on claiming a position and never take a lock. The consumer
+ *  spins briefly on an empty ring and then sleeps on an atomic wait, which producers only
+ *  signal when it is actually asleep. Producers back off while the ring is full.
+ *  As with SyncQueue, closing the ring wakes the consumer and rejects further writes. */
+template <typename T, bool MultiProducer = true>
+class RingQueue
+{
+public:
+
+    static constexpr size_t DEFAULT_CAPACITY = 65536;
+
+    RingQueue(size_t capacity = DEFAULT_CAPACITY)
+    : slots_(roundUpToPowerOfTwo(capacity)),
+      mask_{slots_.size() - 1}
+    {
+        for (size_t i = 0; i < slots_.size(); ++i)
+        {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    };
+
+    RingQueue(const RingQueue&) = delete;
+    RingQueue& operator=(const RingQueue&) = delete;
+
+    /** Pushes the value to the end of the queue, waiting while the queue is full.
+     *  Returns false if the queue has been closed. */
+    bool push(T value)
+    {
+        while (!try_push(value))
+        {
+            if (closed_.load(std::memory_order_relaxed)) return false;
+            std::this_thread::yield();
+        }
+        return true;
+    };
+
+    /** Pushes the value to the end of the queue if there is space. */
+    bool try_push(T& value)
+    {
+        if (closed_.load(std::memory_order_relaxed)) return false;
+
+        Slot* slot;
+        size_t position = tail_.value.load(std::memory_order_relaxed);
+        if constexpr (MultiProducer)
+        {
+            // Claim a position by advancing the tail once its slot has been consumed
+            for (;;)
+            {
+                slot = &slots_[position & mask_];
+                size_t sequence = slot->sequence.load(std::memory_order_acquire);
+                intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+                if (difference == 0)
+                {
+                    if (tail_.value.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+                }
+                else if (difference < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    position = tail_.value.load(std::memory_order_relaxed);
+                }
+            }
+        }
+        else
+        {
+            slot = &slots_[position & mask_];
+            if (slot->sequence.load(std::memory_order_acquire) != position) return false;
+            tail_.value.store(position + 1, std::memory_order_relaxed);
+        }
+
+        slot->value = std::move(value);
+        slot->sequence.store(position + 1, std::memory_order_release);
+        wakeConsumer();
+        return true;
+    };
+
+    /** Waits until present and pops the value from the start of the queue.
+     *  Returns an empty value if waiting on a closed queue. */
+    T pop()
+    {
+        T value {};
+        for (;;)
+        {
+            for (int spin = 0; spin < SPIN_LIMIT; ++spin)
+            {
+                if (closed_.load(std::memory_order_relaxed)) return T{};
+                if (try_pop(value)) return value;
+            }
+
+            // Announce the consumer is going to sleep, then check again before sleeping
+            uint32_t signal = signal_.value.load(std::memory_order_acquire);
+            sleeping_.value.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (closed_.load(std::memory_order_relaxed) || try_pop(value))
+            {
+                sleeping_.value.store(false, std::memory_order_relaxed);
+                return closed_.load(std::memory_order_relaxed) ? T{} : value;
+            }
+            signal_.value.wait(signal, std::memory_order_acquire);
+        }
+    };
+
+    /** Pops the value from the start of the queue if present. Single consumer only. */
+    bool try_pop(T& value)
+    {
+        size_t position = head_.value.load(std::memory_order_relaxed);
+        Slot& slot = slots_[position & mask_];
+        if (slot.sequence.load(std::memory_order_acquire) != position + 1) return false;
+
+        value = std::move(slot.value);
+        slot.sequence.store(position + mask_ + 1, std::memory_order_release);
+        head_.value.store(position + 1, std::memory_order_relaxed);
+        return true;
+    };
+
+    /** Pops up to the given number of values into the output buffer without waiting.
+     *  Returns the number of values popped. Single consumer only. */
+    size_t try_pop_n(T* values, size_t max_count)
+    {
+        size_t count = 0;
+        while (count < max_count && try_pop(values[count]))
+        {
+            ++count;
+        }
+        return count;
+    };
+
+    /** Returns the approximate number of values in the queue. */
+    unsigned int size() const
+    {
+        size_t tail = tail_.value.load(std::memory_order_relaxed);
+        size_t head = head_.value.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    };
+
+    /** Returns the maximum number of values held by the queue. */
+    size_t capacity() const
+    {
+        return slots_.size();
+    };
+
+    /** Prevents future writes and wakes the consumer. Values left in the queue are released on destruction. */
+    void close()
+    {
+        closed_.store(true, std::memory_order_relaxed);
+        signal_.value.fetch_add(1, std::memory_order_release);
+        signal_.value.notify_one();
+    }
+
+    /** Returns true once the queue has been closed. */
+    bool closed() const
+    {
+        return closed_.load(std::memory_order_relaxed);
+    }
+
+private:
+
+    static constexpr int SPIN_LIMIT = 256;
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    /** Keeps each counter on its own cache line to avoid false sharing between threads. */
+    template <typename V>
+    struct alignas(CACHE_LINE_SIZE) Padded
+    {
+        V value {};
+    };
+
+    static size_t roundUpToPowerOfTwo(size_t capacity)
+    {
+        if (capacity < 2) throw std::runtime_error("Ring queue capacity must be at least 2");
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        return size;
+    }
+
+    /** Signals the consumer if it is waiting for new values. Only the first producer to see it asleep signals it. */
+    void wakeConsumer()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping_.value.load(std::memory_order_relaxed) && sleeping_.value.exchange(false, std::memory_order_relaxed))
+        {
+            signal_.value.fetch_add(1, std::memory_order_release);
+            signal_.value.notify_one();
+        }
+    }
+
+    std::vector<Slot> slots_;
+    size_t mask_;
+
+    Padded<std::atomic<size_t>> tail_;
+    Padded<std::atomic<size_t>> head_;
+    Padded<std::atomic<bool>> sleeping_;
+    Padded<std::atomic<uint32_t>> signal_;
+    std::atomic<bool> closed_ = false;
+};
+
+/** Ring queue with a single producer, which claims positions without compare-and-swap. */
+template <typename T>
+using SPSCRingQueue = RingQueue<T, false>;
+
+#endif
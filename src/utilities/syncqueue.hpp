@@ -49,6 +49,7 @@ public:
     /** Returns the size of the queue. */
     unsigned int size()
     {
+      std::unique_lock<std::mutex> lock(lock_); 
       return queue_.size();
     };
 